@@ -0,0 +1,115 @@
+#include "account_store.h"
+#include <algorithm>
+#include "quickfix\fix44\CollateralReport.h"
+#include "fast_convertors.h"
+
+AccountStore::AccountStore()
+	: subscribed(false)
+{
+}
+
+bool AccountStore::apply(const Message& report)
+{
+	string account = report.getField(FIELD::Account);
+	double balance = 0;
+	if(report.isSetField(FIELD::CashOutstanding))
+		balance = FastDoubleConvertor::convert(report.getField(FIELD::CashOutstanding));
+	double used_margin = 0;
+	if(report.isSetField(FXCM_USED_MARGIN))
+		used_margin = FastDoubleConvertor::convert(report.getField(FXCM_USED_MARGIN));
+	char margin_call = 'N';
+	if(report.isSetField(FXCM_MARGIN_CALL))
+		margin_call = report.getField(FXCM_MARGIN_CALL)[0];
+
+	Locker locker(mutex);
+	const int* number = index.find(account);
+	bool added = !number;
+	if(added){
+		index.insert(account, (int)accounts.size());
+		accounts.push_back(AccountState());
+		AccountState& state = accounts.back();
+		state.account = account;
+		state.margin_call = 'N';
+		// The parties do not change, so they are only read the first time.
+		// CollateralReport has a single NoPartyIDs group
+		if(report.isSetField(FIELD::NoPartyIDs)){
+			FIX44::CollateralReport::NoPartyIDs group;
+			report.getGroup(1, group);
+			int count = group.isSetField(FIELD::NoPartySubIDs) ? FastIntConvertor::convert(group.getField(FIELD::NoPartySubIDs)) : 0;
+			FIX44::CollateralReport::NoPartyIDs::NoPartySubIDs sub_group;
+			for(int i = 1; i <= count; i++){
+				group.getGroup(i, sub_group);
+				state.party_sub_ids.push_back(make_pair(
+					FastIntConvertor::convert(sub_group.getField(FIELD::PartySubIDType)),
+					sub_group.getField(FIELD::PartySubID)));
+			}
+		}
+	}
+
+	AccountState& state = added ? accounts.back() : accounts[*number];
+	double old_utilisation = state.marginUtilisation();
+	bool changed = state.used_margin != used_margin || state.balance != balance || state.margin_call != margin_call;
+	state.balance = balance;
+	state.used_margin = used_margin;
+	state.margin_call = margin_call;
+	state.updates++;
+	if(changed){
+		for(size_t i = 0; i < listeners.size(); i++)
+			listeners[i]->onMarginChange(state, old_utilisation);
+	}
+	return added;
+}
+
+bool AccountStore::find(const string& account, AccountState& state) const
+{
+	Locker locker(mutex);
+	const int* number = index.find(account);
+	if(!number)
+		return false;
+	state = accounts[*number];
+	return true;
+}
+
+vector<string> AccountStore::getAccountIDs() const
+{
+	Locker locker(mutex);
+	vector<string> account_IDs;
+	account_IDs.reserve(accounts.size());
+	for(size_t i = 0; i < accounts.size(); i++)
+		account_IDs.push_back(accounts[i].account);
+	return account_IDs;
+}
+
+size_t AccountStore::size() const
+{
+	Locker locker(mutex);
+	return accounts.size();
+}
+
+bool AccountStore::startSubscription()
+{
+	Locker locker(mutex);
+	if(subscribed)
+		return false;
+	subscribed = true;
+	return true;
+}
+
+// The accounts stay known; the next snapshot refreshes them
+void AccountStore::onLogout()
+{
+	Locker locker(mutex);
+	subscribed = false;
+}
+
+void AccountStore::addListener(AccountListener* listener)
+{
+	Locker locker(mutex);
+	listeners.push_back(listener);
+}
+
+void AccountStore::removeListener(AccountListener* listener)
+{
+	Locker locker(mutex);
+	listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
@@ -0,0 +1,89 @@
+#ifndef ACCOUNTSTORE_H
+#define ACCOUNTSTORE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "quickfix\Message.h"
+#include "quickfix\Mutex.h"
+#include "open_hash_map.h"
+
+using namespace std;
+using namespace FIX;
+
+// An account under our login as its latest CollateralReport describes it
+struct AccountState
+{
+	string account;
+	// CashOutstanding (901): the balance, without the P&L of open positions
+	double balance;
+	// FXCMUsedMargin (9038)
+	double used_margin;
+	// FXCMMarginCall (9045): 'Y' margin call, 'W' warning, 'N' none
+	char margin_call;
+	// PartySubIDType and PartySubID of the NoPartySubIDs entries (account name,
+	// hedging status, ...), read from the first report only
+	vector<pair<int, string> > party_sub_ids;
+	// Reports applied so far
+	unsigned int updates;
+
+	// Share of the balance used as margin
+	double marginUtilisation() const { return balance > 0 ? used_margin / balance : 0; }
+};
+
+// Told when the margin use or margin call status of an account changes
+class AccountListener
+{
+public:
+	virtual ~AccountListener() {}
+	virtual void onMarginChange(const AccountState& account, double old_utilisation) = 0;
+};
+
+// The accounts of our login, kept from CollateralReports: the snapshot that
+// answers a CollateralInquiry and, when subscribed, an update whenever an
+// account changes. Each report is parsed once into an AccountState, found
+// through an OpenHashMap, so an update costs the same with thousands of
+// accounts as with one. Listeners hear of margin changes as they happen.
+//
+// All members lock one mutex.
+class AccountStore
+{
+public:
+	AccountStore();
+
+	// Applies a CollateralReport; true if the account is new
+	bool apply(const Message& report);
+
+	bool find(const string& account, AccountState& state) const;
+	// Account IDs in the order they were first reported
+	vector<string> getAccountIDs() const;
+	size_t size() const;
+
+	// True the first time after construction or onLogout; the caller then
+	// subscribes to collateral updates
+	bool startSubscription();
+	void onLogout();
+
+	// Listeners are called with the mutex held and must not call back into the store
+	void addListener(AccountListener* listener);
+	void removeListener(AccountListener* listener);
+
+private:
+	AccountStore(const AccountStore&);
+	AccountStore& operator=(const AccountStore&);
+
+	enum FXCM_FIX_FIELDS
+	{
+		FXCM_USED_MARGIN = 9038,
+		FXCM_MARGIN_CALL = 9045
+	};
+
+	mutable Mutex mutex;
+	vector<AccountState> accounts;
+	// Account ID to its index in accounts
+	OpenHashMap<int> index;
+	bool subscribed;
+	vector<AccountListener*> listeners;
+};
+
+#endif // ACCOUNTSTORE_H
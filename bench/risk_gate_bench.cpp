@@ -0,0 +1,124 @@
+// -- Risk gate benchmark --
+//
+// Times RiskGate::check over orders spread across 300 instruments and 1000
+// accounts, a tenth of them with limits of their own, which is more than an
+// FXCM login has. Checks that each kind of refusal is reported before timing,
+// then times the check with every limit on, with the time taken from the clock
+// on each call as FixApplication does. Build from the repository root, e.g.
+//
+//   cl /O2 /EHsc /I. /Iquickfix\include bench\risk_gate_bench.cpp risk_gate.cpp
+//
+// --
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "risk_gate.h"
+
+using namespace std;
+
+namespace
+{
+const int INSTRUMENTS = 300;
+const int ACCOUNTS = 1000;
+
+struct Order
+{
+	string account;
+	int instrument_id;
+	double quantity;
+	double exposure;
+};
+
+string accountName(int number)
+{
+	return "0" + to_string(2000000 + number);
+}
+
+template <typename Function>
+double nanosPerOrder(const vector<Order>& orders, int rounds, Function function)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int r = 0; r < rounds; r++){
+		for(size_t i = 0; i < orders.size(); i++)
+			function(orders[i]);
+	}
+	chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+	return (double)elapsed.count() / ((double)rounds * orders.size());
+}
+}
+
+int main()
+{
+	RiskGate gate;
+	RiskLimits defaults = { 5000000, 20000000 };
+	gate.setDefaultLimits(defaults);
+	RiskLimits none = RiskLimits();
+	for(int i = 0; i < INSTRUMENTS; i++)
+		gate.setInstrumentLimits(i, 1000, 50000000, none);
+	RiskLimits small = { 100000, 500000 };
+	for(int a = 0; a < ACCOUNTS; a += 10)
+		gate.setAccountLimits(accountName(a), small);
+
+	// Each refusal must come out for the right reason before the speed means anything
+	struct Case { string account; int instrument_id; double quantity; double exposure; RiskGate::Result expected; };
+	Case cases[] = {
+		{ accountName(1), 7, 10000, 0, RiskGate::ACCEPTED },
+		{ accountName(1), INSTRUMENTS, 10000, 0, RiskGate::UNKNOWN_INSTRUMENT },
+		{ accountName(1), -1, 10000, 0, RiskGate::UNKNOWN_INSTRUMENT },
+		{ accountName(1), 7, 10, 0, RiskGate::BELOW_MIN_QTY },
+		{ accountName(1), 7, 60000000, 0, RiskGate::ABOVE_MAX_QTY },
+		{ accountName(1), 7, 6000000, 0, RiskGate::ABOVE_ORDER_LIMIT },
+		{ accountName(1), 7, 1000000, 19500000, RiskGate::ABOVE_POSITION_LIMIT },
+		{ accountName(0), 7, 200000, 0, RiskGate::ABOVE_ORDER_LIMIT },
+		{ accountName(0), 7, 100000, 450000, RiskGate::ABOVE_POSITION_LIMIT },
+		{ accountName(0), 7, 100000, 0, RiskGate::ACCEPTED }
+	};
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+		RiskGate::Result result = gate.check(cases[i].account, cases[i].instrument_id, cases[i].quantity, cases[i].exposure);
+		if(result != cases[i].expected){
+			printf("case %d: %s, expected %s\n", (int)i, RiskGate::describe(result), RiskGate::describe(cases[i].expected));
+			return 1;
+		}
+	}
+	gate.setKillSwitch(true);
+	if(gate.check(accountName(1), 7, 10000, 0) != RiskGate::KILL_SWITCH){
+		printf("kill switch not applied\n");
+		return 1;
+	}
+	gate.setKillSwitch(false);
+	gate.setRateLimit(2, 2);
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	bool limited = gate.check(accountName(1), 7, 10000, 0, now) == RiskGate::ACCEPTED
+		&& gate.check(accountName(1), 7, 10000, 0, now) == RiskGate::ACCEPTED
+		&& gate.check(accountName(1), 7, 10000, 0, now) == RiskGate::RATE_LIMITED
+		&& gate.check(accountName(1), 7, 10000, 0, now + chrono::milliseconds(500)) == RiskGate::ACCEPTED;
+	if(!limited){
+		printf("rate limit not applied\n");
+		return 1;
+	}
+
+	vector<Order> orders;
+	for(int i = 0; i < 4096; i++){
+		Order order = { accountName(i * 7 % ACCOUNTS), i * 13 % INSTRUMENTS, (double)(1 + i % 50) * 1000, (double)(i % 9) * 100000 };
+		orders.push_back(order);
+	}
+
+	// High enough that the timed orders are never throttled, so every check runs to the end
+	gate.setRateLimit(1e12, 1e12);
+	const int rounds = 500;
+	size_t sink = 0;
+	double clock_ns = nanosPerOrder(orders, rounds, [&](const Order& o){
+		sink += gate.check(o.account, o.instrument_id, o.quantity, o.exposure);
+	});
+	now = chrono::steady_clock::now();
+	double check_ns = nanosPerOrder(orders, rounds, [&](const Order& o){
+		sink += gate.check(o.account, o.instrument_id, o.quantity, o.exposure, now);
+	});
+
+	printf("%d orders, %d instruments, %d accounts\n", (int)orders.size(), INSTRUMENTS, ACCOUNTS);
+	printf("check           %8.1f ns/order\n", clock_ns);
+	printf("check (no clock)%8.1f ns/order\n", check_ns);
+	return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// -- Tokenizer benchmark --
+//
+// Times FixTokenizer over MarketDataSnapshotFullRefresh messages shaped like the
+// ones the FXCM MD_ session sends: four MDEntries (bid, offer, high, low) plus the
+// FXCM symbol fields. Compares the vector scan the build selects with the scalar
+// loop, and framing with messageLength. Build from the repository root, e.g.
+//
+//   g++ -O2 -mavx2 -I. bench/tokenizer_bench.cpp fix_tokenizer.cpp
+//   cl /O2 /arch:AVX2 /I. bench\tokenizer_bench.cpp fix_tokenizer.cpp
+//
+// --
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "fix_tokenizer.h"
+
+using namespace std;
+
+namespace
+{
+const char* SYMBOLS[] = { "EUR/USD", "USD/JPY", "GBP/USD", "EUR/JPY", "EUR/GBP", "AUD/USD" };
+const double PRICES[] = { 1.11234, 109.512, 1.30781, 121.801, 0.85047, 0.68912 };
+const int DIGITS[] = { 5, 3, 5, 3, 5, 5 };
+
+string formatPrice(double price, int digits)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, price);
+	return buffer;
+}
+
+string entry(char type, const string& price, const string& time)
+{
+	return string("269=") + type + "\001270=" + price + "\001271=0\001272=20200110\001273=" + time
+		+ "\001336=FXCM\001625=U100D2\001276=A\001282=FXCM\001";
+}
+
+// Builds a complete message with correct BodyLength and CheckSum
+string snapshot(int symbol, int sequence)
+{
+	double step = sequence % 17 * 0.00001 * (DIGITS[symbol] == 3 ? 100 : 1);
+	double bid = PRICES[symbol] + step;
+	double ask = bid + 0.00019 * (DIGITS[symbol] == 3 ? 100 : 1);
+	string time = "10:00:" + string(sequence % 60 < 10 ? "0" : "") + to_string(sequence % 60) + ".123";
+	string body = "35=W\00134=" + to_string(sequence) + "\00149=FXCM\00150=U100D2\001"
+		"52=20200110-" + time + "\00156=MD_D291092855_client1\001262=" + SYMBOLS[symbol]
+		+ "_Request_\00155=" + SYMBOLS[symbol] + "\001228=1\00115=EUR\001460=4\001167=FOR\001"
+		"9002=0.0001\0019001=" + to_string(DIGITS[symbol]) + "\0019005=100\0019011=0\0019000="
+		+ to_string(symbol + 1) + "\0019095=1\0019094=50000000\001268=4\001"
+		+ entry('0', formatPrice(bid, DIGITS[symbol]), time)
+		+ entry('1', formatPrice(ask, DIGITS[symbol]), time)
+		+ entry('7', formatPrice(ask + 0.001, DIGITS[symbol]), time)
+		+ entry('8', formatPrice(bid - 0.001, DIGITS[symbol]), time);
+	string message = "8=FIX.4.4\0019=" + to_string(body.size()) + "\001" + body;
+	unsigned int sum = FixTokenizer::byteSum(message.data(), message.size());
+	char trailer[8];
+	snprintf(trailer, sizeof(trailer), "10=%03u\001", sum % 256);
+	return message + trailer;
+}
+
+template <typename Function>
+double nanosPerMessage(const vector<string>& messages, int rounds, Function function)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int r = 0; r < rounds; r++){
+		for(size_t i = 0; i < messages.size(); i++)
+			function(messages[i]);
+	}
+	chrono::nanoseconds elapsed = chrono::steady_clock::now() - start;
+	return (double)elapsed.count() / ((double)rounds * messages.size());
+}
+}
+
+int main()
+{
+	vector<string> messages;
+	size_t bytes = 0;
+	for(int i = 0; i < 1200; i++){
+		messages.push_back(snapshot(i % 6, i + 1));
+		bytes += messages.back().size();
+	}
+
+	// Both paths must agree before their speed means anything
+	FixTokenizer::Tokens fast;
+	FixTokenizer::Tokens scalar;
+	for(size_t i = 0; i < messages.size(); i++){
+		const string& m = messages[i];
+		int fast_sum = -1;
+		int scalar_sum = -2;
+		size_t length = 0;
+		bool ok = FixTokenizer::tokenize(m.data(), m.size(), fast, fast_sum)
+			&& FixTokenizer::tokenizeScalar(m.data(), m.size(), scalar, scalar_sum)
+			&& FixTokenizer::messageLength(m.data(), m.size(), length);
+		ok = ok && fast.size() == scalar.size() && fast_sum == scalar_sum && length == m.size()
+			&& fast.back().tag == 10 && atoi(m.c_str() + fast.back().offset) == fast_sum;
+		for(size_t t = 0; ok && t < fast.size(); t++)
+			ok = fast[t].tag == scalar[t].tag && fast[t].offset == scalar[t].offset && fast[t].length == scalar[t].length;
+		if(!ok){
+			printf("mismatch on message %d\n", (int)i);
+			return 1;
+		}
+	}
+
+	const int rounds = 500;
+	size_t sink = 0;
+	double vector_ns = nanosPerMessage(messages, rounds, [&](const string& m){
+		int checksum;
+		FixTokenizer::tokenize(m.data(), m.size(), fast, checksum);
+		sink += fast.size() + checksum;
+	});
+	double scalar_ns = nanosPerMessage(messages, rounds, [&](const string& m){
+		int checksum;
+		FixTokenizer::tokenizeScalar(m.data(), m.size(), scalar, checksum);
+		sink += scalar.size() + checksum;
+	});
+	double frame_ns = nanosPerMessage(messages, rounds, [&](const string& m){
+		size_t length;
+		FixTokenizer::messageLength(m.data(), m.size(), length);
+		sink += length;
+	});
+
+	printf("%d messages, %d bytes on average\n", (int)messages.size(), (int)(bytes / messages.size()));
+	printf("tokenize        %8.1f ns/message\n", vector_ns);
+	printf("tokenizeScalar  %8.1f ns/message\n", scalar_ns);
+	printf("messageLength   %8.1f ns/message\n", frame_ns);
+	return sink == 0 ? 1 : 0;
+}
\ No newline at end of file
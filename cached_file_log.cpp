@@ -0,0 +1,100 @@
+#include "cached_file_log.h"
+#include <sstream>
+
+Log* CachedFileLogFactory::create()
+{
+	return create(settings.get(), "GLOBAL");
+}
+
+Log* CachedFileLogFactory::create(const SessionID& session_ID)
+{
+	// Same file name prefix as FIX::FileLog
+	string prefix = session_ID.getBeginString().getString() + "-"
+		+ session_ID.getSenderCompID().getString() + "-"
+		+ session_ID.getTargetCompID().getString();
+	if(session_ID.getSessionQualifier().size())
+		prefix += "-" + session_ID.getSessionQualifier();
+	return create(settings.get(session_ID), prefix);
+}
+
+Log* CachedFileLogFactory::create(const Dictionary& dictionary, const string& prefix)
+{
+	string path = dictionary.getString(FILE_LOG_PATH);
+	return new CachedFileLog(path, prefix, clock, timestampPrecision(dictionary));
+}
+
+int CachedFileLogFactory::timestampPrecision(const Dictionary& dictionary)
+{
+	if(dictionary.has(TIMESTAMP_PRECISION))
+		return TimestampFormatter::precision(dictionary.getInt(TIMESTAMP_PRECISION));
+	if(dictionary.has(MILLISECONDS_IN_TIMESTAMP) && !dictionary.getBool(MILLISECONDS_IN_TIMESTAMP))
+		return 0;
+	return 3;
+}
+
+void CachedFileLogFactory::destroy(Log* log)
+{
+	delete log;
+}
+
+CachedFileLog::CachedFileLog(const string& path, const string& prefix, const Clock& clock, int fraction_digits)
+	: clock(clock), formatter(fraction_digits)
+{
+	file_mkdir(path.c_str());
+	full_prefix = file_appendpath(path, prefix + ".");
+	messages_file_name = full_prefix + "messages.current.log";
+	events_file_name = full_prefix + "event.current.log";
+	open(ios::out | ios::app);
+}
+
+CachedFileLog::~CachedFileLog()
+{
+	messages.close();
+	events.close();
+}
+
+void CachedFileLog::open(ios_base::openmode mode)
+{
+	messages.open(messages_file_name.c_str(), mode);
+	if(!messages.is_open())
+		throw ConfigError("Could not open messages file: " + messages_file_name);
+	events.open(events_file_name.c_str(), mode);
+	if(!events.is_open())
+		throw ConfigError("Could not open event file: " + events_file_name);
+}
+
+void CachedFileLog::clear()
+{
+	messages.close();
+	events.close();
+	open(ios::out | ios::trunc);
+}
+
+// Moves the current files aside as <prefix>.messages.backup.<n>.log and
+// <prefix>.event.backup.<n>.log with the first unused n, then starts new ones
+void CachedFileLog::backup()
+{
+	messages.close();
+	events.close();
+	for(int i = 1; ; i++){
+		ostringstream number;
+		number << i;
+		string messages_backup = full_prefix + "messages.backup." + number.str() + ".log";
+		string events_backup = full_prefix + "event.backup." + number.str() + ".log";
+		if(!file_exists(messages_backup.c_str()) && !file_exists(events_backup.c_str())){
+			file_rename(messages_file_name.c_str(), messages_backup.c_str());
+			file_rename(events_file_name.c_str(), events_backup.c_str());
+			break;
+		}
+	}
+	open(ios::out | ios::app);
+}
+
+void CachedFileLog::write(ofstream& stream, const string& value)
+{
+	const char* timestamp = formatter.format(clock.now());
+	stream.write(timestamp, formatter.length());
+	stream.write(" : ", 3);
+	stream.write(value.data(), value.size());
+	stream << endl;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef CACHEDFILELOG_H
+#define CACHEDFILELOG_H
+
+#include <fstream>
+#include <string>
+#include "quickfix\Log.h"
+#include "quickfix\SessionSettings.h"
+#include "utc_clock.h"
+
+using namespace std;
+using namespace FIX;
+
+const char TIMESTAMP_PRECISION[] = "TimestampPrecision";
+
+// Drop-in replacement for FIX::FileLogFactory. Writes the same files
+// (<prefix>.messages.current.log and <prefix>.event.current.log under
+// FileLogPath) in the same "timestamp : text" format. The timestamps come from the
+// shared Clock and a TimestampFormatter, so a line costs a clock read and a few
+// digits instead of a gmtime call and a string build.
+//
+// Log lines carry TimestampPrecision (0, 3, 6 or 9) fractional digits; without
+// that setting MillisecondsInTimeStamp decides between 3 and 0 as for FileLog.
+// Incoming lines are written on receipt, before the engine parses the message,
+// so at 6 or 9 digits they record the receive time for latency analysis.
+class CachedFileLogFactory : public LogFactory
+{
+public:
+	CachedFileLogFactory(const SessionSettings& settings, const Clock& clock)
+		: settings(settings), clock(clock) {}
+
+	Log* create();
+	Log* create(const SessionID& session_ID);
+	void destroy(Log* log);
+
+	// Fraction digits configured by TimestampPrecision or MillisecondsInTimeStamp
+	static int timestampPrecision(const Dictionary& dictionary);
+
+private:
+	Log* create(const Dictionary& dictionary, const string& prefix);
+
+	SessionSettings settings;
+	const Clock& clock;
+};
+
+class CachedFileLog : public Log
+{
+public:
+	CachedFileLog(const string& path, const string& prefix, const Clock& clock, int fraction_digits);
+	~CachedFileLog();
+
+	void clear();
+	void backup();
+
+	void onIncoming(const string& value) { write(messages, value); }
+	void onOutgoing(const string& value) { write(messages, value); }
+	void onEvent(const string& value) { write(events, value); }
+
+private:
+	void write(ofstream& stream, const string& value);
+	void open(ios_base::openmode mode);
+
+	const Clock& clock;
+	TimestampFormatter formatter;
+	string full_prefix;
+	string messages_file_name;
+	string events_file_name;
+	ofstream messages;
+	ofstream events;
+};
+
+#endif // CACHEDFILELOG_H
\ No newline at end of file
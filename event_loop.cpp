@@ -0,0 +1,279 @@
+#include "event_loop.h"
+#include <sstream>
+#include "quickfix\FieldConvertors.h"
+#include "fast_socket_initiator.h"
+#include "thread_affinity.h"
+
+namespace
+{
+bool connectInProgress()
+{
+#ifdef _MSC_VER
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EINPROGRESS;
+#endif
+}
+}
+
+EventLoop::EventLoop(FastSocketInitiator& initiator, int index, const Dictionary& settings)
+	: initiator(initiator)
+	, index(index)
+	, name("fix-loop-" + IntConvertor::convert(index))
+	, cpu(-1)
+	, monitor(EventMonitor::create(settings))
+	, thread(0)
+	, last_connect(0)
+	, last_timer(0)
+	, reconnect_interval(30)
+	, no_delay(false)
+	, send_buffer_size(0)
+	, receive_buffer_size(0)
+	, socket_busy_poll(0)
+	, busy_poll(false)
+	, spin_budget(0)
+{
+	string number = IntConvertor::convert(index);
+	if(settings.has(EVENT_LOOP_CPU + number))
+		cpu = settings.getInt(EVENT_LOOP_CPU + number);
+	if(settings.has(EVENT_LOOP_NAME + number))
+		name = settings.getString(EVENT_LOOP_NAME + number);
+	if(settings.has(RECONNECT_INTERVAL))
+		reconnect_interval = settings.getInt(RECONNECT_INTERVAL);
+	if(settings.has(SOCKET_NODELAY))
+		no_delay = settings.getBool(SOCKET_NODELAY);
+	if(settings.has(SOCKET_SEND_BUFFER_SIZE))
+		send_buffer_size = settings.getInt(SOCKET_SEND_BUFFER_SIZE);
+	if(settings.has(SOCKET_RECEIVE_BUFFER_SIZE))
+		receive_buffer_size = settings.getInt(SOCKET_RECEIVE_BUFFER_SIZE);
+	if(settings.has(SOCKET_BUSY_POLL))
+		socket_busy_poll = settings.getInt(SOCKET_BUSY_POLL);
+	if(settings.has(BUSY_POLL))
+		busy_poll = settings.getBool(BUSY_POLL);
+	if(settings.has(BUSY_POLL_SPIN))
+		spin_budget = chrono::microseconds(settings.getInt(BUSY_POLL_SPIN));
+}
+
+EventLoop::~EventLoop()
+{
+	for(Connections::iterator i = connections.begin(); i != connections.end(); ++i)
+		delete i->second;
+	for(Connections::iterator i = pending_connections.begin(); i != pending_connections.end(); ++i)
+		delete i->second;
+	delete monitor;
+}
+
+void EventLoop::requestConnect(const SessionID& session_ID, const Dictionary& dictionary)
+{
+	Locker locker(request_mutex);
+	connect_requests.push_back(make_pair(session_ID, dictionary));
+}
+
+bool EventLoop::spawn()
+{
+	return thread_spawn(&startThread, this, thread);
+}
+
+void EventLoop::join()
+{
+	if(thread)
+		thread_join(thread);
+	thread = 0;
+}
+
+THREAD_PROC EventLoop::startThread(void* p)
+{
+	static_cast<EventLoop*>(p)->run();
+	return 0;
+}
+
+void EventLoop::run()
+{
+	if(cpu >= 0 && !pinCurrentThread(cpu))
+		initiator.logEvent("Could not pin " + name + " to CPU " + IntConvertor::convert(cpu));
+	nameCurrentThread(name);
+
+	last_event = chrono::steady_clock::now();
+	while(!initiator.isStopped()){
+		startConnects();
+		waitForEvents();
+		onTimer();
+	}
+
+	// Give the logouts sent by stop() a few seconds to be answered
+	time_t start = ::time(NULL);
+	while(initiator.isLoggedOn()){
+		monitor->block(*this, 1.0);
+		if(::time(NULL) - 5 >= start)
+			break;
+	}
+}
+
+void EventLoop::poll(double timeout)
+{
+	startConnects();
+	monitor->block(*this, timeout);
+	onTimer();
+}
+
+void EventLoop::waitForEvents()
+{
+	if(!busy_poll){
+		monitor->block(*this, 1.0);
+		return;
+	}
+	bool spinning = spin_budget.count() == 0 || chrono::steady_clock::now() - last_event < spin_budget;
+	if(monitor->block(*this, spinning ? 0.0 : 1.0) > 0)
+		last_event = chrono::steady_clock::now();
+}
+
+void EventLoop::startConnects()
+{
+	ConnectRequests requests;
+	{
+		Locker locker(request_mutex);
+		if(connect_requests.empty())
+			return;
+		requests.swap(connect_requests);
+	}
+	for(size_t i = 0; i < requests.size(); i++)
+		connect(requests[i].first, requests[i].second);
+}
+
+void EventLoop::connect(const SessionID& session_ID, const Dictionary& dictionary)
+{
+	try{
+		Session* session = Session::lookupSession(session_ID);
+		string address;
+		short port = 0;
+		getHost(session_ID, dictionary, address, port);
+		session->getLog()->onEvent("Connecting to " + address + " on port " + IntConvertor::convert((unsigned short)port));
+
+		int socket = socket_createConnector();
+		if(socket < 0){
+			initiator.setDisconnected(session_ID);
+			return;
+		}
+		if(no_delay)
+			socket_setsockopt(socket, TCP_NODELAY);
+		if(send_buffer_size)
+			socket_setsockopt(socket, SO_SNDBUF, send_buffer_size);
+		if(receive_buffer_size)
+			socket_setsockopt(socket, SO_RCVBUF, receive_buffer_size);
+#ifdef SO_BUSY_POLL
+		if(socket_busy_poll)
+			socket_setsockopt(socket, SO_BUSY_POLL, socket_busy_poll);
+#endif
+		socket_setnonblock(socket);
+		if(socket_connect(socket, address.c_str(), port) != 0 && !connectInProgress()){
+			session->getLog()->onEvent("Connection failed");
+			socket_close(socket);
+			initiator.setDisconnected(session_ID);
+			return;
+		}
+
+		monitor->addConnect(socket);
+		pending_connections[socket] = new FastSocketConnection(initiator, session_ID, socket, *monitor);
+	}catch(exception&){
+		initiator.setDisconnected(session_ID);
+	}
+}
+
+void EventLoop::onConnect(EventMonitor&, int socket)
+{
+	Connections::iterator i = pending_connections.find(socket);
+	if(i == pending_connections.end())
+		return;
+	FastSocketConnection* connection = i->second;
+	connections[socket] = connection;
+	pending_connections.erase(i);
+	initiator.setConnected(connection->getSession()->getSessionID());
+	// Sends the Logon
+	connection->onTimeout();
+}
+
+void EventLoop::onEvent(EventMonitor&, int socket)
+{
+	Connections::iterator i = connections.find(socket);
+	if(i != connections.end() && !i->second->read())
+		i->second->disconnect();
+}
+
+void EventLoop::onWrite(EventMonitor&, int socket)
+{
+	Connections::iterator i = connections.find(socket);
+	if(i != connections.end())
+		i->second->onWrite();
+}
+
+// The socket is closed by now; forget its connection and tell the session
+void EventLoop::onError(EventMonitor&, int socket)
+{
+	FastSocketConnection* connection = NULL;
+	Connections::iterator i = connections.find(socket);
+	if(i != connections.end()){
+		connection = i->second;
+		connections.erase(i);
+	}
+	i = pending_connections.find(socket);
+	if(i != pending_connections.end()){
+		connection = i->second;
+		pending_connections.erase(i);
+	}
+	if(!connection)
+		return;
+
+	Session* session = connection->getSession();
+	if(session){
+		session->disconnect();
+		initiator.setDisconnected(session->getSessionID());
+	}
+	delete connection;
+}
+
+void EventLoop::onError(EventMonitor&)
+{
+}
+
+void EventLoop::onTimer()
+{
+	time_t now = ::time(NULL);
+	if(now == last_timer)
+		return;
+	last_timer = now;
+
+	// Initiator::connect hands each disconnected session to its own loop
+	if(index == 0 && now - last_connect >= reconnect_interval){
+		initiator.connect();
+		last_connect = now;
+	}
+	for(Connections::iterator i = connections.begin(); i != connections.end(); ++i)
+		i->second->onTimeout();
+}
+
+// Uses SocketConnectHost<n>/SocketConnectPort<n> in turn on each reconnect, back
+// to SocketConnectHost/SocketConnectPort after the last numbered pair
+void EventLoop::getHost(const SessionID& session_ID, const Dictionary& dictionary, string& address, short& port)
+{
+	int num = 0;
+	SessionToHostNum::iterator i = session_to_host_num.find(session_ID);
+	if(i != session_to_host_num.end())
+		num = i->second;
+
+	stringstream host_stream;
+	host_stream << SOCKET_CONNECT_HOST << num;
+	string host_key = host_stream.str();
+	stringstream port_stream;
+	port_stream << SOCKET_CONNECT_PORT << num;
+	string port_key = port_stream.str();
+
+	if(dictionary.has(host_key) && dictionary.has(port_key)){
+		address = dictionary.getString(host_key);
+		port = (short)dictionary.getInt(port_key);
+	}else{
+		num = 0;
+		address = dictionary.getString(SOCKET_CONNECT_HOST);
+		port = (short)dictionary.getInt(SOCKET_CONNECT_PORT);
+	}
+	session_to_host_num[session_ID] = ++num;
+}
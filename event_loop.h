@@ -0,0 +1,104 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include "quickfix\Dictionary.h"
+#include "quickfix\Mutex.h"
+#include "quickfix\SessionID.h"
+#include "event_monitor.h"
+#include "fast_socket_connection.h"
+
+using namespace std;
+using namespace FIX;
+
+const char BUSY_POLL[] = "BusyPoll";
+const char BUSY_POLL_SPIN[] = "BusyPollSpin";
+const char SOCKET_BUSY_POLL[] = "SocketBusyPoll";
+// Suffixed with the loop number: EventLoopCPU0, EventLoopName1, ...
+const char EVENT_LOOP_CPU[] = "EventLoopCPU";
+const char EVENT_LOOP_NAME[] = "EventLoopName";
+
+class FastSocketInitiator;
+
+// One socket thread of a FastSocketInitiator: an EventMonitor and the
+// connections of the sessions assigned to it. Everything except requestConnect
+// runs on the loop's own thread, so the connection maps need no locking.
+//
+// With BusyPoll=Y the loop polls without sleeping, so a quote is picked up as
+// soon as it arrives instead of after a wakeup from select or epoll_wait.
+// BusyPollSpin is how many microseconds without traffic it spins before going
+// back to sleeping until the next event (0, the default, spins for good), and
+// SocketBusyPoll sets SO_BUSY_POLL (microseconds) on each socket where the
+// system supports it. EventLoopCPU<n> pins loop n to a core and EventLoopName<n>
+// names its thread (fix-loop-<n> by default).
+class EventLoop : public EventMonitor::Strategy
+{
+public:
+	EventLoop(FastSocketInitiator& initiator, int index, const Dictionary& settings);
+	~EventLoop();
+
+	// Queues a connect for a session of this loop; safe from any thread. The loop
+	// opens the socket on its next turn
+	void requestConnect(const SessionID& session_ID, const Dictionary& dictionary);
+
+	// Runs the loop on a new thread, or on the calling one
+	bool spawn();
+	void join();
+	void run();
+	// One turn of at most timeout seconds, for FastSocketInitiator::onPoll
+	void poll(double timeout);
+
+private:
+	typedef map<int, FastSocketConnection*> Connections;
+	typedef map<SessionID, int> SessionToHostNum;
+	typedef vector<pair<SessionID, Dictionary> > ConnectRequests;
+
+	static THREAD_PROC startThread(void* p);
+
+	void startConnects();
+	void connect(const SessionID& session_ID, const Dictionary& dictionary);
+	// One wait on the monitor: a zero timeout poll while spinning, otherwise a
+	// sleep of up to a second
+	void waitForEvents();
+	// Runs the session timers, and on loop 0 the reconnects, at most once a
+	// second however busy the sockets are
+	void onTimer();
+	void getHost(const SessionID& session_ID, const Dictionary& dictionary, string& address, short& port);
+
+	void onConnect(EventMonitor& monitor, int socket);
+	void onEvent(EventMonitor& monitor, int socket);
+	void onWrite(EventMonitor& monitor, int socket);
+	void onError(EventMonitor& monitor, int socket);
+	void onError(EventMonitor& monitor);
+
+	FastSocketInitiator& initiator;
+	int index;
+	string name;
+	int cpu;
+	EventMonitor *monitor;
+	thread_id thread;
+
+	Mutex request_mutex;
+	ConnectRequests connect_requests;
+
+	Connections pending_connections;
+	Connections connections;
+	SessionToHostNum session_to_host_num;
+	time_t last_connect;
+	time_t last_timer;
+	int reconnect_interval;
+	bool no_delay;
+	int send_buffer_size;
+	int receive_buffer_size;
+	int socket_busy_poll;
+
+	bool busy_poll;
+	chrono::microseconds spin_budget;
+	chrono::steady_clock::time_point last_event;
+};
+
+#endif // EVENTLOOP_H
@@ -0,0 +1,368 @@
+#include "event_monitor.h"
+#include "quickfix\Exceptions.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+EventMonitor* EventMonitor::create(const Dictionary& settings)
+{
+#ifdef __linux__
+	string name = "Epoll";
+#else
+	string name = "Select";
+#endif
+	if(settings.has(SOCKET_MONITOR))
+		name = settings.getString(SOCKET_MONITOR);
+
+	if(name == "Select")
+		return new SelectMonitor();
+	if(name == "Epoll"){
+#ifdef __linux__
+		bool edge_triggered = false;
+		if(settings.has(EPOLL_TRIGGER)){
+			string trigger = settings.getString(EPOLL_TRIGGER);
+			if(trigger != "Level" && trigger != "Edge")
+				throw ConfigError("EpollTrigger must be Level or Edge, not " + trigger);
+			edge_triggered = trigger == "Edge";
+		}
+		return new EpollMonitor(edge_triggered);
+#else
+		throw ConfigError("SocketMonitor=Epoll is only available on Linux");
+#endif
+	}
+	throw ConfigError("SocketMonitor must be Select or Epoll, not " + name);
+}
+
+bool EventMonitor::wouldBlock()
+{
+#ifdef _MSC_VER
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+bool EventMonitor::connectSucceeded(int socket)
+{
+	int error = 0;
+	if(socket_getsockopt(socket, SO_ERROR, error) != 0)
+		return false;
+	return error == 0;
+}
+
+SelectMonitor::SelectMonitor()
+	: max_socket(0)
+{
+	FD_ZERO(&connect_set);
+	FD_ZERO(&read_set);
+	FD_ZERO(&write_set);
+
+	pair<int, int> sockets = socket_createpair();
+	signal_socket = sockets.first;
+	interrupt_socket = sockets.second;
+	socket_setnonblock(signal_socket);
+	socket_setnonblock(interrupt_socket);
+	FD_SET(interrupt_socket, &read_set);
+	max_socket = interrupt_socket;
+}
+
+SelectMonitor::~SelectMonitor()
+{
+	for(set<int>::iterator i = connect_sockets.begin(); i != connect_sockets.end(); ++i)
+		socket_close(*i);
+	for(set<int>::iterator i = read_sockets.begin(); i != read_sockets.end(); ++i)
+		socket_close(*i);
+	socket_close(signal_socket);
+	socket_close(interrupt_socket);
+}
+
+// Connecting sockets wait in both connect_set and write_set: connect_set tells
+// them apart from signalled ones and doubles as the except set, which is where
+// Windows reports a failed connect
+bool SelectMonitor::addConnect(int socket)
+{
+	Locker locker(mutex);
+	if(!connect_sockets.insert(socket).second)
+		return false;
+	FD_SET(socket, &connect_set);
+	FD_SET(socket, &write_set);
+	if(socket > max_socket)
+		max_socket = socket;
+	return true;
+}
+
+bool SelectMonitor::addRead(int socket)
+{
+	Locker locker(mutex);
+	if(!read_sockets.insert(socket).second)
+		return false;
+	FD_SET(socket, &read_set);
+	if(socket > max_socket)
+		max_socket = socket;
+	return true;
+}
+
+bool SelectMonitor::drop(int socket)
+{
+	Locker locker(mutex);
+	// Signals of this socket still in the pair would otherwise be read after the
+	// number has been given to a new socket
+	drainSignals();
+	bool watched = connect_sockets.erase(socket) + read_sockets.erase(socket) > 0;
+	if(!watched)
+		return false;
+	write_sockets.erase(socket);
+	FD_CLR(socket, &connect_set);
+	FD_CLR(socket, &read_set);
+	FD_CLR(socket, &write_set);
+	socket_close(socket);
+	dropped.push_back(socket);
+
+	max_socket = interrupt_socket;
+	if(!connect_sockets.empty() && *connect_sockets.rbegin() > max_socket)
+		max_socket = *connect_sockets.rbegin();
+	if(!read_sockets.empty() && *read_sockets.rbegin() > max_socket)
+		max_socket = *read_sockets.rbegin();
+	return true;
+}
+
+void SelectMonitor::signal(int socket)
+{
+	Locker locker(mutex);
+	if(!read_sockets.count(socket))
+		return;
+	socket_send(signal_socket, (const char*)&socket, sizeof(socket));
+}
+
+void SelectMonitor::unsignal(int socket)
+{
+	Locker locker(mutex);
+	if(write_sockets.erase(socket))
+		FD_CLR(socket, &write_set);
+}
+
+void SelectMonitor::drainSignals()
+{
+	Locker locker(mutex);
+	int socket;
+	while(recv(interrupt_socket, (char*)&socket, sizeof(socket), 0) == sizeof(socket)){
+		if(read_sockets.count(socket) && write_sockets.insert(socket).second)
+			FD_SET(socket, &write_set);
+	}
+}
+
+int SelectMonitor::block(Strategy& strategy, double timeout)
+{
+	if(!dropped.empty()){
+		vector<int> closed;
+		closed.swap(dropped);
+		for(size_t i = 0; i < closed.size(); i++)
+			strategy.onError(*this, closed[i]);
+		return (int)closed.size();
+	}
+
+	fd_set reads;
+	fd_set writes;
+	fd_set errors;
+	{
+		Locker locker(mutex);
+		reads = read_set;
+		writes = write_set;
+		errors = connect_set;
+	}
+	timeval wait;
+	timeval* wait_pointer = NULL;
+	if(timeout >= 0){
+		wait.tv_sec = (long)timeout;
+		wait.tv_usec = (long)((timeout - wait.tv_sec) * 1000000);
+		wait_pointer = &wait;
+	}
+
+	int result = select(max_socket + 1, &reads, &writes, &errors, wait_pointer);
+	if(result == 0){
+		strategy.onTimeout(*this);
+		return 0;
+	}
+	if(result < 0){
+		strategy.onError(*this);
+		return 0;
+	}
+
+	// Callbacks add and drop sockets, so walk copies and recheck membership
+	vector<int> sockets(connect_sockets.begin(), connect_sockets.end());
+	for(size_t i = 0; i < sockets.size(); i++){
+		int socket = sockets[i];
+		bool failed = FD_ISSET(socket, &errors) != 0;
+		if(!failed && !FD_ISSET(socket, &writes))
+			continue;
+		bool connected = !failed && connectSucceeded(socket);
+		{
+			Locker locker(mutex);
+			connect_sockets.erase(socket);
+			FD_CLR(socket, &connect_set);
+			FD_CLR(socket, &write_set);
+			if(connected)
+				addRead(socket);
+			else
+				socket_close(socket);
+		}
+		if(connected)
+			strategy.onConnect(*this, socket);
+		else
+			strategy.onError(*this, socket);
+	}
+
+	sockets.assign(read_sockets.begin(), read_sockets.end());
+	for(size_t i = 0; i < sockets.size(); i++){
+		if(FD_ISSET(sockets[i], &reads) && read_sockets.count(sockets[i]))
+			strategy.onEvent(*this, sockets[i]);
+	}
+	sockets.assign(write_sockets.begin(), write_sockets.end());
+	for(size_t i = 0; i < sockets.size(); i++){
+		if(FD_ISSET(sockets[i], &writes) && write_sockets.count(sockets[i]))
+			strategy.onWrite(*this, sockets[i]);
+	}
+
+	if(FD_ISSET(interrupt_socket, &reads))
+		drainSignals();
+	return result;
+}
+
+#ifdef __linux__
+EpollMonitor::EpollMonitor(bool edge_triggered)
+	: epoll_socket(epoll_create1(EPOLL_CLOEXEC))
+	, edge_triggered(edge_triggered)
+{
+	if(epoll_socket < 0)
+		throw RuntimeError("Could not create epoll instance");
+}
+
+EpollMonitor::~EpollMonitor()
+{
+	for(map<int, SocketState>::iterator i = sockets.begin(); i != sockets.end(); ++i)
+		socket_close(i->first);
+	close(epoll_socket);
+}
+
+bool EpollMonitor::control(int operation, int socket, unsigned int events)
+{
+	epoll_event event;
+	event.events = events | (edge_triggered ? (unsigned int)EPOLLET : 0u);
+	event.data.fd = socket;
+	return epoll_ctl(epoll_socket, operation, socket, &event) == 0;
+}
+
+bool EpollMonitor::addConnect(int socket)
+{
+	Locker locker(mutex);
+	if(sockets.count(socket) || !control(EPOLL_CTL_ADD, socket, EPOLLOUT))
+		return false;
+	sockets[socket] = CONNECTING;
+	return true;
+}
+
+bool EpollMonitor::addRead(int socket)
+{
+	Locker locker(mutex);
+	if(sockets.count(socket) || !control(EPOLL_CTL_ADD, socket, EPOLLIN))
+		return false;
+	sockets[socket] = CONNECTED;
+	return true;
+}
+
+bool EpollMonitor::drop(int socket)
+{
+	Locker locker(mutex);
+	map<int, SocketState>::iterator i = sockets.find(socket);
+	if(i == sockets.end())
+		return false;
+	sockets.erase(i);
+	epoll_ctl(epoll_socket, EPOLL_CTL_DEL, socket, NULL);
+	socket_close(socket);
+	dropped.push_back(socket);
+	return true;
+}
+
+// epoll_ctl is safe to call while another thread waits, and a modified socket
+// that is already writable is reported to that wait straight away
+void EpollMonitor::signal(int socket)
+{
+	Locker locker(mutex);
+	map<int, SocketState>::const_iterator i = sockets.find(socket);
+	if(i == sockets.end() || i->second != CONNECTED)
+		return;
+	control(EPOLL_CTL_MOD, socket, EPOLLIN | EPOLLOUT);
+}
+
+void EpollMonitor::unsignal(int socket)
+{
+	Locker locker(mutex);
+	map<int, SocketState>::const_iterator i = sockets.find(socket);
+	if(i == sockets.end() || i->second != CONNECTED)
+		return;
+	control(EPOLL_CTL_MOD, socket, EPOLLIN);
+}
+
+int EpollMonitor::block(Strategy& strategy, double timeout)
+{
+	if(!dropped.empty()){
+		vector<int> closed;
+		closed.swap(dropped);
+		for(size_t i = 0; i < closed.size(); i++)
+			strategy.onError(*this, closed[i]);
+		return (int)closed.size();
+	}
+
+	epoll_event events[MAX_EVENTS];
+	int milliseconds = timeout < 0 ? -1 : (int)(timeout * 1000);
+	int count = epoll_wait(epoll_socket, events, MAX_EVENTS, milliseconds);
+	if(count == 0){
+		strategy.onTimeout(*this);
+		return 0;
+	}
+	if(count < 0){
+		if(errno != EINTR)
+			strategy.onError(*this);
+		return 0;
+	}
+
+	for(int i = 0; i < count; i++){
+		int socket = events[i].data.fd;
+		unsigned int flags = events[i].events;
+		// Skip sockets dropped by an earlier callback in this batch
+		map<int, SocketState>::iterator state = sockets.find(socket);
+		if(state == sockets.end())
+			continue;
+
+		if(state->second == CONNECTING){
+			bool connected = (flags & (EPOLLERR | EPOLLHUP)) == 0 && connectSucceeded(socket);
+			{
+				Locker locker(mutex);
+				if(connected){
+					state->second = CONNECTED;
+					control(EPOLL_CTL_MOD, socket, EPOLLIN);
+				}else{
+					sockets.erase(state);
+					epoll_ctl(epoll_socket, EPOLL_CTL_DEL, socket, NULL);
+					socket_close(socket);
+				}
+			}
+			if(connected)
+				strategy.onConnect(*this, socket);
+			else
+				strategy.onError(*this, socket);
+			continue;
+		}
+
+		// Errors and hangups go to the reader, whose recv reports them
+		if(flags & (EPOLLIN | EPOLLERR | EPOLLHUP))
+			strategy.onEvent(*this, socket);
+		if((flags & EPOLLOUT) && sockets.count(socket))
+			strategy.onWrite(*this, socket);
+	}
+	return count;
+}
+#endif
@@ -0,0 +1,146 @@
+#ifndef EVENTMONITOR_H
+#define EVENTMONITOR_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include "quickfix\Dictionary.h"
+#include "quickfix\Mutex.h"
+#include "quickfix\Utility.h"
+
+using namespace std;
+using namespace FIX;
+
+const char SOCKET_MONITOR[] = "SocketMonitor";
+const char EPOLL_TRIGGER[] = "EpollTrigger";
+
+// Waits for socket events on behalf of FastSocketInitiator and reports them
+// through the same callbacks as FIX::SocketMonitor::Strategy. The backend is chosen
+// with the SocketMonitor setting:
+//   Select - select() over fd_sets that are kept between calls and only copied per
+//            wait; limited to FD_SETSIZE sockets. Available everywhere
+//   Epoll  - an epoll instance that holds the interest set in the kernel, so a wait
+//            costs the same however many sessions are connected. Linux only; the
+//            EpollTrigger setting (Level or Edge) selects how readiness is reported
+//
+// signal() and unsignal() may be called from any thread; everything else belongs
+// to the thread that calls block(). They are ignored for a socket the monitor no
+// longer watches: the monitor's mutex orders them against drop, so a signal from
+// a sender that has not noticed the drop cannot arm a closed socket, or a new one
+// that was given the same number.
+class EventMonitor
+{
+public:
+	class Strategy
+	{
+	public:
+		virtual ~Strategy() {}
+		// A connect started with addConnect completed; the socket is now read
+		virtual void onConnect(EventMonitor& monitor, int socket) = 0;
+		// The socket is readable, or the peer closed it
+		virtual void onEvent(EventMonitor& monitor, int socket) = 0;
+		// A signalled socket is writable
+		virtual void onWrite(EventMonitor& monitor, int socket) = 0;
+		// The socket failed or was dropped; it is already closed
+		virtual void onError(EventMonitor& monitor, int socket) = 0;
+		// The wait itself failed
+		virtual void onError(EventMonitor& monitor) = 0;
+		// Nothing happened within the timeout
+		virtual void onTimeout(EventMonitor&) {}
+	};
+
+	virtual ~EventMonitor() {}
+
+	// Watches a non-blocking socket with a connect in progress
+	virtual bool addConnect(int socket) = 0;
+	// Watches a connected socket for reads
+	virtual bool addRead(int socket) = 0;
+	// Closes the socket and stops watching it; onError(socket) is reported on the
+	// next block() so that its owner can clean up outside the current callback
+	virtual bool drop(int socket) = 0;
+	// Asks for onWrite until unsignal; used when a send could not complete
+	virtual void signal(int socket) = 0;
+	virtual void unsignal(int socket) = 0;
+
+	// Waits at most timeout seconds (forever if negative, not at all if zero) and
+	// dispatches whatever is ready. Returns the number of sockets reported
+	virtual int block(Strategy& strategy, double timeout) = 0;
+
+	// With edge triggered readiness a readable socket must be read until it would
+	// block, because it is not reported again until new data arrives
+	virtual bool isEdgeTriggered() const { return false; }
+
+	// The monitor configured by SocketMonitor and EpollTrigger; Epoll on Linux and
+	// Select elsewhere by default. Throws ConfigError for unknown values
+	static EventMonitor* create(const Dictionary& settings);
+
+	// True if the last socket call failed only because it would have blocked
+	static bool wouldBlock();
+
+protected:
+	// Connect result of a socket reported writable while connecting
+	static bool connectSucceeded(int socket);
+
+	// Held by signal and unsignal, and by the block() thread while it changes which
+	// sockets are watched or closes one; never while calling the Strategy
+	Mutex mutex;
+};
+
+class SelectMonitor : public EventMonitor
+{
+public:
+	SelectMonitor();
+	~SelectMonitor();
+
+	bool addConnect(int socket);
+	bool addRead(int socket);
+	bool drop(int socket);
+	void signal(int socket);
+	void unsignal(int socket);
+	int block(Strategy& strategy, double timeout);
+
+private:
+	void drainSignals();
+
+	set<int> connect_sockets;
+	set<int> read_sockets;
+	set<int> write_sockets;
+	fd_set connect_set;
+	fd_set read_set;
+	fd_set write_set;
+	int max_socket;
+	vector<int> dropped;
+	// signal() sends the socket number through this pair to wake up select
+	int signal_socket;
+	int interrupt_socket;
+};
+
+#ifdef __linux__
+class EpollMonitor : public EventMonitor
+{
+public:
+	explicit EpollMonitor(bool edge_triggered);
+	~EpollMonitor();
+
+	bool addConnect(int socket);
+	bool addRead(int socket);
+	bool drop(int socket);
+	void signal(int socket);
+	void unsignal(int socket);
+	int block(Strategy& strategy, double timeout);
+	bool isEdgeTriggered() const { return edge_triggered; }
+
+private:
+	enum SocketState { CONNECTING, CONNECTED };
+	static const int MAX_EVENTS = 64;
+
+	bool control(int operation, int socket, unsigned int events);
+
+	int epoll_socket;
+	bool edge_triggered;
+	map<int, SocketState> sockets;
+	vector<int> dropped;
+};
+#endif
+
+#endif // EVENTMONITOR_H
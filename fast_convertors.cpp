@@ -0,0 +1,184 @@
+#include "fast_convertors.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+// Powers of ten that are exact in a double
+const double POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int MAX_EXACT_POWER = 22;
+// Integers below 2^53 are exact in a double
+const double EXACT_INTEGER_LIMIT = 9007199254740992.0;
+const int MAX_FAST_DIGITS = 15;
+const int MAX_FAST_DECIMALS = 15;
+
+// Writes the digits of value right-aligned so that they end at end
+char* writeDigitsBackwards(char* end, unsigned long long value)
+{
+	do{
+		*--end = (char)('0' + value % 10);
+		value /= 10;
+	}while(value != 0);
+	return end;
+}
+
+int countDigits(unsigned long long value)
+{
+	int digits = 1;
+	while(value >= 10){
+		value /= 10;
+		digits++;
+	}
+	return digits;
+}
+
+char* copyIfFits(char* first, char* last, const char* text, size_t length)
+{
+	if((size_t)(last - first) < length)
+		return NULL;
+	memcpy(first, text, length);
+	return first + length;
+}
+}
+
+char* FastIntConvertor::toChars(char* first, char* last, int value)
+{
+	unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+	int length = countDigits(magnitude) + (value < 0 ? 1 : 0);
+	if(last - first < length)
+		return NULL;
+	writeDigitsBackwards(first + length, magnitude);
+	if(value < 0)
+		*first = '-';
+	return first + length;
+}
+
+bool FastIntConvertor::fromChars(const char* first, const char* last, int& value)
+{
+	bool negative = first < last && *first == '-';
+	if(negative)
+		first++;
+	if(first == last || last - first > 10)
+		return false;
+	long long result = 0;
+	for(; first < last; first++){
+		unsigned int digit = (unsigned char)*first - '0';
+		if(digit > 9)
+			return false;
+		result = result * 10 + digit;
+	}
+	if(negative)
+		result = -result;
+	if(result > 2147483647LL || result < -2147483647LL - 1)
+		return false;
+	value = (int)result;
+	return true;
+}
+
+char* FastDoubleConvertor::toChars(char* first, char* last, double value)
+{
+	if(value != value || value - value != 0)
+		return NULL; // NaN or infinity have no FIX representation
+
+	bool negative = value < 0;
+	double magnitude = negative ? -value : value;
+
+	// Fewest decimals whose integer mantissa divides back to exactly magnitude.
+	// Integer / exact power of ten is correctly rounded, the same as parsing the text
+	for(int decimals = 0; decimals <= MAX_FAST_DECIMALS; decimals++){
+		double scaled = magnitude * POW10[decimals];
+		if(scaled >= EXACT_INTEGER_LIMIT)
+			break;
+		unsigned long long mantissa = (unsigned long long)(scaled + 0.5);
+		if((double)mantissa / POW10[decimals] != magnitude)
+			continue;
+
+		int digits = countDigits(mantissa);
+		if(digits <= decimals)
+			digits = decimals + 1; // leading "0."
+		int length = (negative ? 1 : 0) + digits + (decimals > 0 ? 1 : 0);
+		if(last - first < length)
+			return NULL;
+
+		char* p = first + length;
+		for(int i = 0; i < decimals; i++){
+			*--p = (char)('0' + mantissa % 10);
+			mantissa /= 10;
+		}
+		if(decimals > 0)
+			*--p = '.';
+		p = writeDigitsBackwards(p, mantissa);
+		if(negative)
+			*--p = '-';
+		return first + length;
+	}
+
+	// Too large or too many decimals for an exact mantissa
+	char buffer[512];
+	int length = snprintf(buffer, sizeof(buffer), "%.15f", value);
+	if(length <= 0 || length >= (int)sizeof(buffer))
+		return NULL;
+	while(buffer[length - 1] == '0')
+		length--;
+	if(buffer[length - 1] == '.')
+		length--;
+	return copyIfFits(first, last, buffer, length);
+}
+
+bool FastDoubleConvertor::fromChars(const char* first, const char* last, double& value)
+{
+	const char* p = first;
+	bool negative = p < last && *p == '-';
+	if(negative)
+		p++;
+
+	unsigned long long mantissa = 0;
+	int significant = 0;
+	int decimals = 0;
+	bool point = false;
+	bool any_digit = false;
+	for(; p < last; p++){
+		if(*p == '.'){
+			if(point)
+				return false;
+			point = true;
+			continue;
+		}
+		unsigned int digit = (unsigned char)*p - '0';
+		if(digit > 9)
+			return false;
+		any_digit = true;
+		if(point)
+			decimals++;
+		if(mantissa == 0 && digit == 0)
+			continue; // leading zeros are not significant
+		if(++significant > MAX_FAST_DIGITS)
+			break;
+		mantissa = mantissa * 10 + digit;
+	}
+	if(!any_digit && p == last)
+		return false;
+
+	if(p == last && decimals <= MAX_EXACT_POWER){
+		double result = (double)mantissa / POW10[decimals];
+		value = negative ? -result : result;
+		return true;
+	}
+
+	// More digits than fit an exact mantissa; strtod needs a terminated copy
+	size_t length = last - first;
+	string copy(first, length);
+	for(size_t i = 0; i < length; i++){
+		if((copy[i] < '0' || copy[i] > '9') && copy[i] != '.' && !(i == 0 && copy[i] == '-'))
+			return false;
+	}
+	if(copy.find('.') != copy.rfind('.'))
+		return false;
+	char* end = NULL;
+	value = strtod(copy.c_str(), &end);
+	return end == copy.c_str() + length;
+}
\ No newline at end of file
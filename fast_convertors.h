@@ -0,0 +1,69 @@
+#ifndef FASTCONVERTORS_H
+#define FASTCONVERTORS_H
+
+#include <string>
+#include "quickfix\Exceptions.h"
+
+using namespace std;
+using namespace FIX;
+
+// Number <-> text conversions in the style of C++17 to_chars/from_chars, for the
+// hot paths where IntConvertor and DoubleConvertor show up: nothing is allocated,
+// output goes into a buffer the caller owns and input is read in place.
+
+struct FastIntConvertor
+{
+	// Longest output: sign and ten digits
+	enum { MAX_CHARS = 11 };
+
+	// Writes value into [first, last) and returns one past the last character
+	// written, or NULL if it does not fit. No terminating null is written
+	static char* toChars(char* first, char* last, int value);
+	// Parses all of [first, last) as an optionally negative decimal integer
+	static bool fromChars(const char* first, const char* last, int& value);
+
+	static int convert(const string& value)
+	{
+		int result;
+		if(!fromChars(value.data(), value.data() + value.size(), result))
+			throw FieldConvertError(value);
+		return result;
+	}
+};
+
+struct FastDoubleConvertor
+{
+	// Longest output: sign, 17 significant digits, a point and leading zeros
+	enum { MAX_CHARS = 40 };
+
+	// Writes the shortest fixed-point text that parses back to exactly value, e.g.
+	// 1.08345 rather than 1.0834500000000001. FIX does not allow exponents, so
+	// values that need more than 15 decimals or 17 significant digits are written
+	// with 15 decimals like DoubleConvertor. Returns NULL if the text does not fit
+	static char* toChars(char* first, char* last, double value);
+	// Parses all of [first, last) as a FIX float. Values with up to 15 significant
+	// digits (every price FXCM sends) are converted exactly with one integer parse
+	// and one division; longer ones go through strtod
+	static bool fromChars(const char* first, const char* last, double& value);
+
+	static double convert(const string& value)
+	{
+		double result;
+		if(!fromChars(value.data(), value.data() + value.size(), result))
+			throw FieldConvertError(value);
+		return result;
+	}
+
+	// Throws FieldConvertError for NaN, infinity and values too long to write
+	// without an exponent, such as 1e40
+	static string convert(double value)
+	{
+		char buffer[MAX_CHARS];
+		char* end = toChars(buffer, buffer + sizeof(buffer), value);
+		if(!end)
+			throw FieldConvertError();
+		return string(buffer, end);
+	}
+};
+
+#endif // FASTCONVERTORS_H
\ No newline at end of file
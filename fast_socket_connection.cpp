@@ -0,0 +1,182 @@
+#include "fast_socket_connection.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+namespace
+{
+// A closed peer must not raise SIGPIPE; the failed send is noticed by the reader
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+// Messages gathered into one send call
+const int MAX_BATCH = 64;
+
+// Sends up to MAX_BATCH queued messages, the first from offset, with a single
+// gathering write. Returns the bytes sent or -1
+ssize_t sendBatch(int socket, const deque<string>& queue, size_t offset)
+{
+	size_t count = 0;
+#ifdef _WIN32
+	WSABUF buffers[MAX_BATCH];
+	for(deque<string>::const_iterator i = queue.begin(); i != queue.end() && count < MAX_BATCH; ++i, offset = 0, count++){
+		buffers[count].buf = (CHAR*)i->data() + offset;
+		buffers[count].len = (ULONG)(i->size() - offset);
+	}
+	DWORD sent = 0;
+	if(WSASend(socket, buffers, (DWORD)count, &sent, 0, NULL, NULL) != 0)
+		return -1;
+	return (ssize_t)sent;
+#else
+	iovec buffers[MAX_BATCH];
+	for(deque<string>::const_iterator i = queue.begin(); i != queue.end() && count < MAX_BATCH; ++i, offset = 0, count++){
+		buffers[count].iov_base = (void*)(i->data() + offset);
+		buffers[count].iov_len = i->size() - offset;
+	}
+	msghdr header = msghdr();
+	header.msg_iov = buffers;
+	header.msg_iovlen = count;
+	return sendmsg(socket, &header, SEND_FLAGS);
+#endif
+}
+}
+
+thread_local const string* FastSocketConnection::receiving = NULL;
+
+FastSocketConnection::FastSocketConnection(Initiator& initiator, const SessionID& session_ID, int socket,
+	EventMonitor& monitor)
+	: socket(socket)
+	, session(initiator.getSession(session_ID, *this))
+	, monitor(monitor)
+	, send_offset(0)
+	, signalled(false)
+	, dropped(false)
+{
+}
+
+FastSocketConnection::~FastSocketConnection()
+{
+	if(session)
+		Session::unregisterSession(session->getSessionID());
+}
+
+// A receive that fills the free space may have left more behind, so keep
+// reading until one comes back short. Edge triggered monitors do not report the
+// socket again for data already there, so then read until it would block.
+// A Logout or a fatal message makes the session disconnect while its messages
+// are passed on, and then the socket number is no longer ours to read
+bool FastSocketConnection::read()
+{
+	if(!session)
+		return false;
+	bool drained;
+	do{
+		size_t free;
+		char* tail = buffer.prepare(free);
+		ssize_t size = recv(socket, tail, (int)free, 0);
+		if(size <= 0){
+			if(size < 0 && EventMonitor::wouldBlock())
+				return true;
+			session->getLog()->onEvent(SocketRecvFailed(size).what());
+			return false;
+		}
+		buffer.commit(size);
+		if(!readMessages() || isDropped())
+			return false;
+		drained = (size_t)size < free;
+	}while(!drained || monitor.isEdgeTriggered());
+	return true;
+}
+
+bool FastSocketConnection::readMessages()
+{
+	const char* data;
+	size_t length;
+	while(buffer.next(data, length)){
+		message.assign(data, length);
+		receiving = &message;
+		try{
+			session->next(message, UtcTimeStamp());
+		}catch(InvalidMessage&){
+			receiving = NULL;
+			if(!session->isLoggedOn())
+				return false;
+		}
+		receiving = NULL;
+		if(isDropped())
+			return false;
+	}
+	return true;
+}
+
+void FastSocketConnection::onWrite()
+{
+	Locker locker(mutex);
+	// Unsignalled even if this connection did not ask: a sender of the connection
+	// that had the socket number before may have signalled it just before its drop
+	if(processQueue()){
+		signalled = false;
+		monitor.unsignal(socket);
+	}
+}
+
+void FastSocketConnection::onTimeout()
+{
+	if(session)
+		session->next();
+}
+
+// While earlier messages are queued the socket is signalled already, and the
+// message waits to go out with them
+bool FastSocketConnection::send(const string& message)
+{
+	Locker locker(mutex);
+	if(dropped)
+		return false;
+	send_queue.push_back(message);
+	if(send_queue.size() > 1)
+		return true;
+	if(!processQueue() && !signalled){
+		signalled = true;
+		monitor.signal(socket);
+	}
+	return true;
+}
+
+bool FastSocketConnection::processQueue()
+{
+	while(!send_queue.empty()){
+		ssize_t sent = sendBatch(socket, send_queue, send_offset);
+		if(sent <= 0)
+			return false; // full, or failed and about to be seen by read()
+		size_t remaining = send_offset + sent;
+		while(!send_queue.empty() && remaining >= send_queue.front().size()){
+			remaining -= send_queue.front().size();
+			send_queue.pop_front();
+		}
+		send_offset = remaining;
+		if(send_offset > 0)
+			return false; // the socket took part of a message, so it is full
+	}
+	return true;
+}
+
+// After the drop the socket number may be reused at once, so send() must not
+// write to it or signal it any more
+void FastSocketConnection::disconnect()
+{
+	Locker locker(mutex);
+	if(dropped)
+		return;
+	dropped = true;
+	monitor.drop(socket);
+}
+
+bool FastSocketConnection::isDropped()
+{
+	Locker locker(mutex);
+	return dropped;
+}
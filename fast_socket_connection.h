@@ -0,0 +1,75 @@
+#ifndef FASTSOCKETCONNECTION_H
+#define FASTSOCKETCONNECTION_H
+
+#include <deque>
+#include <string>
+#include "quickfix\Initiator.h"
+#include "quickfix\Mutex.h"
+#include "quickfix\Responder.h"
+#include "quickfix\Session.h"
+#include "event_monitor.h"
+#include "receive_buffer.h"
+
+using namespace std;
+using namespace FIX;
+
+// The transport of one FastSocketInitiator session. Reads run on the monitor
+// thread; send() is called by the Session from whichever thread sends. Queued
+// messages go out together in one gathering write (writev style sendmsg, or
+// WSASend on Windows), so a burst costs one system call instead of one each.
+//
+// send() writes straight away while nothing is queued. What the socket does not
+// take waits for onWrite, and everything sent meanwhile joins it in one write.
+class FastSocketConnection : public Responder
+{
+public:
+	FastSocketConnection(Initiator& initiator, const SessionID& session_ID, int socket,
+		EventMonitor& monitor);
+	~FastSocketConnection();
+
+	int getSocket() const { return socket; }
+	Session* getSession() const { return session; }
+
+	// Reads everything that has arrived and passes complete messages to the
+	// session. Returns false if the socket failed or was closed by the peer
+	bool read();
+	// Flushes queued data after the monitor reported the socket writable
+	void onWrite();
+	// Lets the session send heartbeats and check its timers
+	void onTimeout();
+
+	bool send(const string& message);
+	void disconnect();
+
+	// The bytes of the message the calling thread is passing to its session, so that
+	// the application can read them in fromApp without rendering the parsed message
+	// again; NULL outside a read. The session may also hand the application a message
+	// it held back until a gap was filled, so check the MsgSeqNum
+	static const string* received() { return receiving; }
+
+private:
+	bool readMessages();
+
+	static thread_local const string* receiving;
+	// Writes as much of the queue as the socket takes; true once it is empty
+	bool processQueue();
+	// True once disconnect has run, possibly from within session->next
+	bool isDropped();
+
+	int socket;
+	Session* session;
+	EventMonitor& monitor;
+	ReceiveBuffer buffer;
+	// Reused for each message passed to the session
+	string message;
+
+	Mutex mutex;
+	deque<string> send_queue;
+	// Bytes of send_queue.front() already written
+	size_t send_offset;
+	bool signalled;
+	// Set by disconnect; send() fails from then on
+	bool dropped;
+};
+
+#endif // FASTSOCKETCONNECTION_H
@@ -0,0 +1,87 @@
+#include "fast_socket_initiator.h"
+#include "quickfix\FieldConvertors.h"
+
+FastSocketInitiator::FastSocketInitiator(Application& application, MessageStoreFactory& store_factory,
+	const SessionSettings& settings, LogFactory& log_factory) throw(ConfigError)
+	: Initiator(application, store_factory, settings, log_factory)
+	, stop_time(0)
+{
+	socket_init();
+}
+
+FastSocketInitiator::~FastSocketInitiator()
+{
+	for(size_t i = 0; i < loops.size(); i++)
+		delete loops[i];
+	socket_term();
+}
+
+void FastSocketInitiator::onConfigure(const SessionSettings& session_settings) throw(ConfigError)
+{
+	if(!loops.empty())
+		return;
+	const Dictionary& dictionary = session_settings.get();
+	int count = 1;
+	if(dictionary.has(EVENT_LOOPS))
+		count = dictionary.getInt(EVENT_LOOPS);
+	if(count < 1)
+		throw ConfigError("EventLoops must be at least 1");
+
+	set<SessionID> sessions = session_settings.getSessions();
+	for(set<SessionID>::const_iterator i = sessions.begin(); i != sessions.end(); ++i){
+		const Dictionary& session = session_settings.get(*i);
+		int loop = session.has(EVENT_LOOP) ? session.getInt(EVENT_LOOP) : 0;
+		if(loop < 0 || loop >= count)
+			throw ConfigError(i->toString() + ": EventLoop must be below EventLoops (" + IntConvertor::convert(count) + ")");
+		session_loops[*i] = loop;
+	}
+	for(int i = 0; i < count; i++)
+		loops.push_back(new EventLoop(*this, i, dictionary));
+}
+
+void FastSocketInitiator::onStart()
+{
+	connect();
+	for(size_t i = 1; i < loops.size(); i++){
+		if(!loops[i]->spawn())
+			logEvent("Could not start event loop " + IntConvertor::convert((int)i));
+	}
+	loops[0]->run();
+	for(size_t i = 1; i < loops.size(); i++)
+		loops[i]->join();
+}
+
+// Polling drives every loop from the caller's thread; only the first one waits
+bool FastSocketInitiator::onPoll(double timeout)
+{
+	if(isStopped()){
+		if(stop_time == 0)
+			stop_time = ::time(NULL);
+		if(!isLoggedOn() || ::time(NULL) - 5 >= stop_time)
+			return false;
+	}
+	for(size_t i = 0; i < loops.size(); i++)
+		loops[i]->poll(i == 0 ? timeout : 0.0);
+	return true;
+}
+
+void FastSocketInitiator::onStop()
+{
+}
+
+void FastSocketInitiator::logEvent(const string& text)
+{
+	Locker locker(log_mutex);
+	getLog()->onEvent(text);
+}
+
+// Called by Initiator::connect from whichever loop runs the reconnect timer;
+// the session's own loop opens the socket
+void FastSocketInitiator::doConnect(const SessionID& session_ID, const Dictionary& dictionary)
+{
+	Session* session = Session::lookupSession(session_ID);
+	if(!session || !session->isSessionTime(UtcTimeStamp()))
+		return;
+	setPending(session_ID);
+	loops[session_loops[session_ID]]->requestConnect(session_ID, dictionary);
+}
@@ -0,0 +1,57 @@
+#ifndef FASTSOCKETINITIATOR_H
+#define FASTSOCKETINITIATOR_H
+
+#include <ctime>
+#include <map>
+#include <vector>
+#include "quickfix\Initiator.h"
+#include "quickfix\Mutex.h"
+#include "event_loop.h"
+
+using namespace std;
+using namespace FIX;
+
+const char EVENT_LOOPS[] = "EventLoops";
+const char EVENT_LOOP[] = "EventLoop";
+
+// Replacement for FIX::SocketInitiator that waits on an EventMonitor, so the
+// socket backend (select or epoll) is a setting rather than fixed in the engine.
+// Reads the same settings as SocketInitiator: SocketConnectHost[n] and
+// SocketConnectPort[n] with failover, ReconnectInterval, SocketNodelay,
+// SendBufferSize and ReceiveBufferSize, plus SocketMonitor and EpollTrigger.
+//
+// The sessions are spread over EventLoops socket threads (1 by default). A
+// session runs on the loop given by its EventLoop setting, 0 if it has none, so
+// for example the trading session can have a core to itself while the market
+// data sessions share another. See EventLoop for busy polling, CPU pinning and
+// thread names.
+class FastSocketInitiator : public Initiator
+{
+public:
+	FastSocketInitiator(Application& application, MessageStoreFactory& store_factory,
+		const SessionSettings& settings, LogFactory& log_factory) throw(ConfigError);
+	~FastSocketInitiator();
+
+private:
+	friend class EventLoop;
+
+	void onConfigure(const SessionSettings& session_settings) throw(ConfigError);
+
+	// Runs loop 0 on the initiator thread and the others on threads of their own
+	void onStart();
+	bool onPoll(double timeout);
+	void onStop();
+
+	void doConnect(const SessionID& session_ID, const Dictionary& dictionary);
+	// Writes to the initiator's Log, which all loop threads share
+	void logEvent(const string& text);
+
+	vector<EventLoop*> loops;
+	map<SessionID, int> session_loops;
+	// When onPoll first saw the initiator stopped
+	time_t stop_time;
+	// The Log does not lock, so its writes from the loops are serialised here
+	Mutex log_mutex;
+};
+
+#endif // FASTSOCKETINITIATOR_H
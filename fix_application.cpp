@@ -5,8 +5,7 @@ SessionID FixApplication::sessionID(bool md)
 {
 	for (auto session : sessions)
 	{
-		// for FXCM MarketData sessions begin with MD_
-		if ((session.toString().find("MD_") != string::npos) == md)
+		if (IsMarketDataSession(session) == md)
 		{
 			return session;
 		}
@@ -14,11 +13,65 @@ SessionID FixApplication::sessionID(bool md)
 	return SessionID();
 }
 
+// for FXCM MarketData sessions begin with MD_
+bool FixApplication::IsMarketDataSession(const SessionID& session_ID)
+{
+	return session_ID.toString().find("MD_") != string::npos;
+}
+
 FixApplication::FixApplication()
+	: orders(instruments)
+	, position_keeper(instruments)
 {
-	// Initialize unsigned int requestID to 1. We will use this as a 
+	// Initialize requestID to 1. We will use this as a 
 	// counter for making request IDs
 	requestID = 1;
+	clock = &Clock::named("Precise");
+	dispatcher = NULL;
+	quote_cache = NULL;
+	subscriptions = NULL;
+	throttle = NULL;
+	BuildTemplates();
+}
+
+// Sets the fields that are the same for every NewOrderSingle and RequestForPositions
+// we send. MarketOrder and GetPositions then only overwrite IDs, account and times
+void FixApplication::BuildTemplates()
+{
+	FIX44::NewOrderSingle& order = market_order.message();
+	order.setField(ClOrdID(""));
+	order.setField(Account(""));
+	order.setField(Symbol("EUR/USD"));
+	order.setField(TradingSessionID("FXCM"));
+	order.setField(TransactTime());
+	order.setField(OrderQty(10000));
+	order.setField(Side(FIX::Side_BUY));
+	order.setField(OrdType(OrdType_MARKET));
+	order.setField(TimeInForce(FIX::TimeInForce_GOOD_TILL_CANCEL)); // For newer versions of QuickFIX change this to TimeInForce_GOOD_TILL_CANCEL
+
+	FIX44::RequestForPositions& positions = positions_request.message();
+	positions.setField(PosReqID(""));
+	positions.setField(PosReqType(PosReqType_POSITIONS));
+	positions.setField(Account(""));
+	positions.setField(SubscriptionRequestType(SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES));
+	positions.setField(AccountType(
+		AccountType_ACCOUNT_IS_CARRIED_ON_NON_CUSTOMER_SIDE_OF_BOOKS_AND_IS_CROSS_MARGINED));
+	positions.setField(TransactTime());
+	positions.setField(ClearingBusinessDate());
+	positions.setField(TradingSessionID("FXCM"));
+	// Set NoPartyIDs group. These values are always as seen below
+	positions.setField(NoPartyIDs(1));
+	FIX44::RequestForPositions::NoPartyIDs parties_group;
+	parties_group.setField(PartyID("FXCM ID"));
+	parties_group.setField(PartyIDSource('D'));
+	parties_group.setField(PartyRole(3));
+	parties_group.setField(NoPartySubIDs(1));
+	// Set NoPartySubIDs group. PartySubID carries the AccountID of each request
+	FIX44::RequestForPositions::NoPartyIDs::NoPartySubIDs sub_parties;
+	sub_parties.setField(PartySubIDType(PartySubIDType_SECURITIES_ACCOUNT_NUMBER));
+	sub_parties.setField(PartySubID(""));
+	parties_group.addGroup(sub_parties);
+	positions.addGroup(parties_group);
 }
 
 // Gets called when quickfix creates a new session. A session comes into and remains in existence
@@ -29,6 +82,13 @@ void FixApplication::onCreate(const SessionID& session_ID)
 	// the Logon(A) message
 	cout << "Session -> created" << session_ID << endl;
 	sessions.push_back(session_ID);
+	if(dispatcher)
+		dispatcher->addSession(session_ID);
+	// ThrottleRate and ThrottleBurst may differ between the sessions
+	const Dictionary& session_settings = settings->get(session_ID);
+	double rate = session_settings.has(THROTTLE_RATE) ? session_settings.getDouble(THROTTLE_RATE) : 0;
+	double burst = session_settings.has(THROTTLE_BURST) ? session_settings.getDouble(THROTTLE_BURST) : rate;
+	throttle->addSession(session_ID, rate, burst);
 }
 
 // Notifies you when a valid logon has been established with FXCM.
@@ -39,6 +99,10 @@ void FixApplication::onLogon(const SessionID& session_ID)
 	// and to obtain important FXCM system parameters 
 	cout << "Session -> logon" << session_ID << endl;
 	GetTradingStatus();
+	// The server forgot our subscriptions when the previous connection dropped, so
+	// subscribe to everything we want again
+	if(IsMarketDataSession(session_ID))
+		subscriptions->onLogon(session_ID);
 }
 
 // Notifies you when an FIX session is no longer online. This could happen during a normal logout
@@ -47,6 +111,14 @@ void FixApplication::onLogout(const SessionID& session_ID)
 {
 	// Session logout 
 	cout << "Session -> logout" << session_ID << endl;
+	// Orders and requests still waiting were meant for the connection that is gone
+	throttle->clear(session_ID);
+	if(IsMarketDataSession(session_ID))
+		subscriptions->onLogout();
+	else{
+		position_keeper.onLogout();
+		accounts.onLogout();
+	}
 }
 
 // Provides you with a peak at the administrative messages that are being sent from your FIX engine 
@@ -91,6 +163,25 @@ void FixApplication::fromAdmin(const Message& message, const SessionID& session_
 // One of the core entry points for your FIX application. Every application level request will come through here. 
 void FixApplication::fromApp(const Message& message, const SessionID& session_ID)
 {
+	// Quotes go into the cache here, on the socket thread, so that readers of the
+	// cache see them even while the dispatcher is behind
+	bool quote = message.getHeader().getField(FIELD::MsgType) == MsgType_MarketDataSnapshotFullRefresh;
+	if(quote || dispatcher){
+		const RawMessage& wire = WireForm(message);
+		if(quote)
+			UpdateQuote(wire);
+		// With AppQueue=Y the dispatcher thread cracks the message from its wire
+		// bytes, so the socket thread can go back to reading straight away. Only the
+		// latest snapshot of a symbol is kept for it
+		if(dispatcher){
+			StringRef symbol;
+			if(quote && wire.getFieldIfSet(FIELD::Symbol, symbol))
+				dispatcher->postLatest(symbol.str(), wire.toString(), session_ID);
+			else
+				dispatcher->post(wire.toString(), session_ID);
+			return;
+		}
+	}
 	// Call MessageCracker.crack method to handle the message by one of our 
 	// overloaded onMessage methods below
 	crack(message, session_ID);
@@ -119,6 +210,15 @@ void FixApplication::onMessage(const FIX44::TradingSessionStatus& tss, const Ses
 		string symbol = symbols_group.getField(FIELD::Symbol);
 		cout << "    Symbol -> " << symbol << endl;
 	}
+	// Number the instruments and remember their precision and quantity limits, so that
+	// market data and orders can refer to them by instrument ID
+	instruments.update(tss);
+	// FXCM's minimum and maximum order quantity of each instrument become part of its risk limits
+	RiskLimits no_limits = RiskLimits();
+	for(size_t i = 0; i < instruments.size(); i++){
+		const Instrument* instrument = instruments.get((int)i);
+		risk_gate.setInstrumentLimits(instrument->id, instrument->min_quantity, instrument->max_quantity, no_limits);
+	}
 	// Also within TradingSessionStatus are FXCM system parameters. This includes important information
 	// such as account base currency, server time zone, the time at which the trading day ends, and more.
 	cout << "  System Parameters via TradingSessionStatus -> " << endl;
@@ -152,32 +252,21 @@ void FixApplication::onMessage(const FIX44::CollateralInquiryAck& ack, const Ses
 // Notable fields include Account(1) which is the AccountID and CashOutstanding(901) which is the account balance
 void FixApplication::onMessage(const FIX44::CollateralReport& cr, const SessionID& session_ID)
 {
+	// Keep the balance, margin and parties of the account. Reports of accounts we already know
+	// are updates of the subscription and are not printed again
+	if(!accounts.apply(cr))
+		return;
+	AccountState account;
+	accounts.find(cr.getField(FIELD::Account), account);
 	cout << "CollateralReport -> " << endl;
-	string accountID = cr.getField(FIELD::Account);
-	// Get account balance, which is the cash balance in the account, not including any profit
-	// or losses on open trades
-	string balance = cr.getField(FIELD::CashOutstanding);
-	cout << "  AccountID -> " << accountID << endl;
-	cout << "  Balance -> " << balance << endl;
-	// The CollateralReport NoPartyIDs group can be inspected for additional account information
-	// such as AccountName or HedgingStatus
-	FIX44::CollateralReport::NoPartyIDs group;
-	cr.getGroup(1,group); // CollateralReport will only have 1 NoPartyIDs group
+	// Balance is the cash balance in the account, not including any profit or losses on open trades
+	cout << "  AccountID -> " << account.account << endl;
+	cout << "  Balance -> " << cr.getField(FIELD::CashOutstanding) << endl;
+	// The CollateralReport NoPartyIDs group carries additional account information
+	// such as AccountName or HedgingStatus; print out both the PartySubIDType and the PartySubID (the value)
 	cout << "  Parties -> "<< endl;
-	// Get the number of NoPartySubIDs repeating groups
-	int number_subID = IntConvertor::convert(group.getField(FIELD::NoPartySubIDs));
-	// For each group, print out both the PartySubIDType and the PartySubID (the value)
-	for(int u = 1; u <= number_subID; u++){
-		FIX44::CollateralReport::NoPartyIDs::NoPartySubIDs sub_group;
-		group.getGroup(u,sub_group);
-
-		string sub_type = sub_group.getField(FIELD::PartySubIDType);
-		string sub_value = sub_group.getField(FIELD::PartySubID);
-		cout << "    " << sub_type << " -> " << sub_value << endl;
-	}
-	// Add the accountID to our vector<string> being used to track all
-	// accounts under our login
-	RecordAccount(accountID);
+	for(size_t i = 0; i < account.party_sub_ids.size(); i++)
+		cout << "    " << account.party_sub_ids[i].first << " -> " << account.party_sub_ids[i].second << endl;
 }
 
 void FixApplication::onMessage(const FIX44::RequestForPositionsAck& ack, const SessionID& session_ID)
@@ -203,6 +292,7 @@ void FixApplication::onMessage(const FIX44::PositionReport& pr, const SessionID&
 	cout << "   Symbol -> " << symbol << endl;
 	cout << "   PositionID -> " << positionID << endl;
 	cout << "   Open Time -> " << pos_open_time << endl;
+	position_keeper.apply(pr);
 }
 
 void FixApplication::onMessage(const FIX44::MarketDataRequestReject& mdr, const SessionID& session_ID)
@@ -213,6 +303,18 @@ void FixApplication::onMessage(const FIX44::MarketDataRequestReject& mdr, const
 	if(mdr.isSetField(FIELD::Text)){
 		cout << " Text -> " << mdr.getField(FIELD::Text) << endl;
 	}
+	// The reject names the symbol if it is about one symbol of the request; if it does not
+	// and the reason is an unknown symbol, the subscription manager narrows it down by
+	// sending the request again in halves
+	string symbol;
+	if(mdr.isSetField(FIELD::Symbol))
+		symbol = mdr.getField(FIELD::Symbol);
+	char reason = 0;
+	if(mdr.isSetField(FIELD::MDReqRejReason) && !mdr.getField(FIELD::MDReqRejReason).empty())
+		reason = mdr.getField(FIELD::MDReqRejReason)[0];
+	vector<string> rejected = subscriptions->onReject(mdr.getField(FIELD::MDReqID), symbol, reason, session_ID);
+	for(size_t i = 0; i < rejected.size(); i++)
+		cout << " Rejected symbol -> " << rejected[i] << endl;
 }
 
 void FixApplication::onMessage(const FIX44::MarketDataSnapshotFullRefresh& mds, const SessionID& session_ID)
@@ -220,25 +322,95 @@ void FixApplication::onMessage(const FIX44::MarketDataSnapshotFullRefresh& mds,
 	// Get symbol name of the snapshot; e.g., EUR/USD. Our example only subscribes to EUR/USD so 
 	// this is the only possible value
 	string symbol = mds.getField(FIELD::Symbol);
-	// Declare variables for both the bid and ask prices. We will read the MarketDataSnapshotFullRefresh
-	// message for tthese values
-	double bid_price = 0;
-	double ask_price = 0;
-	// For each MDEntry in the message, inspect the NoMDEntries group for
-	// the presence of either the Bid or Ask (Offer) type 
-	int entry_count = IntConvertor::convert(mds.getField(FIELD::NoMDEntries));
-	for(int i = 1; i < entry_count; i++){
-		FIX44::MarketDataSnapshotFullRefresh::NoMDEntries group;
-		mds.getGroup(i,group);
-		string entry_type = group.getField(FIELD::MDEntryType);
-		if(entry_type == "0"){ // Bid
-			bid_price = DoubleConvertor::convert(group.getField(FIELD::MDEntryPx));
-		}else if(entry_type == "1"){ // Ask (Offer)
-			ask_price = DoubleConvertor::convert(group.getField(FIELD::MDEntryPx));
+	// fromApp has already put the prices of the snapshot into the quote cache. With AppQueue=Y
+	// this prints the latest quote, which may be from a later snapshot
+	int instrument_ID = instruments.id(symbol);
+	Quote quote;
+	if(instrument_ID < 0 || instrument_ID >= (int)quote_cache->capacity() || !quote_cache->read(instrument_ID, quote))
+		return;
+	cout << "MarketDataSnapshotFullRefresh -> Symbol - " << symbol 
+		<< " Bid - " << quote.bid.toString() << " Ask - " << quote.ask.toString() << endl; 
+}
+
+// Copies bid, ask, high and low of a MarketDataSnapshotFullRefresh into the quote cache.
+// Prices are scaled integers with the precision of the instrument. Snapshots of symbols
+// that are not in the SecurityList are skipped. The snapshot is read from its wire
+// bytes, straight from the fields it needs, rather than from the parsed Message
+void FixApplication::UpdateQuote(const RawMessage& snapshot)
+{
+	StringRef symbol;
+	if(!snapshot.getFieldIfSet(FIELD::Symbol, symbol))
+		return;
+	const Instrument* instrument = instruments.find(symbol.str());
+	if(!instrument || instrument->id >= (int)quote_cache->capacity())
+		return;
+	size_t entries = snapshot.find(FIELD::NoMDEntries);
+	if(entries == RawMessage::npos)
+		return;
+	StringRef count = snapshot.valueAt(entries);
+	int entry_count;
+	if(!FastIntConvertor::fromChars(count.data, count.data + count.length, entry_count))
+		return;
+
+	// Prices are rounded to the instrument's precision; one beyond what FixedPrice
+	// holds is rounded to the most it can
+	int digits = instrument->digits < FixedPrice::MAX_DIGITS ? instrument->digits : (int)FixedPrice::MAX_DIGITS;
+	Quote quote = Quote();
+	quote.bid = quote.ask = quote.high = quote.low = FixedPrice(0, digits);
+	// For each MDEntry in the message, inspect the NoMDEntries group for the Bid,
+	// Ask (Offer), High and Low types. The fields of a group are read in wire order:
+	// each entry starts with MDEntryType and its MDEntryPx comes before the next one.
+	// An entry without a usable price is skipped; this runs inside fromApp, where
+	// an exception would make the session reject the snapshot
+	size_t entry = snapshot.find(FIELD::MDEntryType, entries + 1);
+	for(int i = 1; i <= entry_count && entry != RawMessage::npos; i++){
+		size_t next = i < entry_count ? snapshot.find(FIELD::MDEntryType, entry + 1) : RawMessage::npos;
+		size_t price_position = snapshot.find(FIELD::MDEntryPx, entry + 1);
+		StringRef entry_type = snapshot.valueAt(entry);
+		FixedPrice price;
+		if(price_position != RawMessage::npos && (next == RawMessage::npos || price_position < next)){
+			StringRef text = snapshot.valueAt(price_position);
+			if(FixedPrice::parse(text.data, text.data + text.length, digits, price)){
+				if(entry_type == "0"){ // Bid
+					quote.bid = price;
+				}else if(entry_type == "1"){ // Ask (Offer)
+					quote.ask = price;
+				}else if(entry_type == "7"){ // Trading session high
+					quote.high = price;
+				}else if(entry_type == "8"){ // Trading session low
+					quote.low = price;
+				}
+			}
 		}
+		entry = next;
 	}
-	cout << "MarketDataSnapshotFullRefresh -> Symbol - " << symbol 
-		<< " Bid - " << bid_price << " Ask - " << ask_price << endl; 
+	StringRef sending_time;
+	if(!snapshot.getFieldIfSet(FIELD::SendingTime, sending_time)
+		|| !parseTimestamp(sending_time.str(), quote.sending_time))
+		quote.sending_time = WallTime();
+	quote.receive_time = clock->now();
+	quote_cache->update(instrument->id, quote);
+	position_keeper.onQuote(instrument->id, quote.bid, quote.ask);
+}
+
+const RawMessage& FixApplication::WireForm(const Message& message)
+{
+	static thread_local RawMessage wire;
+	static thread_local string rendered;
+	const string* received = FastSocketConnection::received();
+	if(received){
+		// Lazily: the header now, the body only as far as the quote reads it
+		wire.assign(received->data(), received->size(), true);
+		StringRef sequence;
+		if(wire.getFieldIfSet(FIELD::MsgSeqNum, sequence)
+			&& sequence == message.getHeader().getField(FIELD::MsgSeqNum).c_str())
+			return wire;
+	}
+	// A message the session held back until a gap was filled, or one that did not
+	// come through a FastSocketConnection
+	message.toString(rendered);
+	wire.assign(rendered.data(), rendered.size(), true);
+	return wire;
 }
 
 void FixApplication::onMessage(const FIX44::ExecutionReport& er, const SessionID& session_ID)
@@ -257,7 +429,9 @@ void FixApplication::onMessage(const FIX44::ExecutionReport& er, const SessionID
 	// use the OrdStatus and CumQty fields. There are 3 possible final values for OrdStatus: Filled (2),
 	// Rejected (8), and Cancelled (4). When the OrdStatus field is set to one of these values, you know
 	// the execution is completed. At this time the CumQty (14) can be inspected to determine if and how
-	// much of an order was filled.
+	// much of an order was filled. The order book does this bookkeeping: it keeps each order up to date
+	// with its latest report and tells its listeners when one is done
+	orders.apply(er);
 }
 
 // Starts the FIX session. Throws FIX::ConfigError exception if our configuration settings
@@ -266,9 +440,49 @@ void FixApplication::StartSession()
 {
 	try{
 		settings      = new SessionSettings("settings.cfg");
+		if(settings->get().has("ClockSource"))
+			clock = &Clock::named(settings->get().getString("ClockSource"));
+		transact_time_format = TimestampFormatter(CachedFileLogFactory::timestampPrecision(settings->get()));
+		if(settings->get().has(APP_QUEUE) && settings->get().getBool(APP_QUEUE)){
+			size_t queue_size = settings->get().has(APP_QUEUE_SIZE) ? settings->get().getInt(APP_QUEUE_SIZE) : 4096;
+			MessageDispatcher::FullPolicy full_policy = MessageDispatcher::BLOCK;
+			if(settings->get().has(APP_QUEUE_FULL))
+				full_policy = MessageDispatcher::policy(settings->get().getString(APP_QUEUE_FULL));
+			// Created before the initiator so that onCreate can add the sessions
+			dispatcher = new MessageDispatcher(* this, queue_size, full_policy);
+		}
+		size_t quote_cache_size = DEFAULT_QUOTE_CACHE_SIZE;
+		if(settings->get().has(QUOTE_CACHE_SIZE))
+			quote_cache_size = settings->get().getInt(QUOTE_CACHE_SIZE);
+		quote_cache   = new QuoteCache(quote_cache_size);
+		size_t batch_size = SubscriptionManager::DEFAULT_BATCH_SIZE;
+		if(settings->get().has(MARKET_DATA_BATCH_SIZE))
+			batch_size = settings->get().getInt(MARKET_DATA_BATCH_SIZE);
+		// Created before the initiator so that onCreate can add the sessions
+		int throttle_interval = OutboundThrottle::DEFAULT_INTERVAL_MS;
+		if(settings->get().has(THROTTLE_INTERVAL))
+			throttle_interval = settings->get().getInt(THROTTLE_INTERVAL);
+		throttle      = new OutboundThrottle(throttle_interval);
+		subscriptions = new SubscriptionManager(* throttle, batch_size);
+		RiskLimits risk_limits = RiskLimits();
+		if(settings->get().has(RISK_MAX_ORDER_QTY))
+			risk_limits.max_order_qty = settings->get().getDouble(RISK_MAX_ORDER_QTY);
+		if(settings->get().has(RISK_MAX_POSITION))
+			risk_limits.max_position = settings->get().getDouble(RISK_MAX_POSITION);
+		risk_gate.setDefaultLimits(risk_limits);
+		if(settings->get().has(RISK_MAX_ORDERS_PER_SECOND)){
+			// Allows a second's worth of orders at once
+			double orders_per_second = settings->get().getDouble(RISK_MAX_ORDERS_PER_SECOND);
+			risk_gate.setRateLimit(orders_per_second, orders_per_second);
+		}
+		if(settings->get().has(RISK_KILL_SWITCH))
+			risk_gate.setKillSwitch(settings->get().getBool(RISK_KILL_SWITCH));
 		store_factory = new FileStoreFactory(* settings);
-		log_factory   = new FileLogFactory(* settings);
-		initiator     = new SocketInitiator(* this, * store_factory, * settings, * log_factory/*Optional*/);
+		log_factory   = new CachedFileLogFactory(* settings, * clock);
+		initiator     = new FastSocketInitiator(* this, * store_factory, * settings, * log_factory/*Optional*/);
+		if(dispatcher)
+			dispatcher->start();
+		throttle->start();
 		initiator->start();
 	}catch(ConfigError error){
 		cout << error.what() << endl;
@@ -278,8 +492,23 @@ void FixApplication::StartSession()
 // Logout and end session 
 void FixApplication::EndSession()
 {
+	// Handlers still queued may send, so they run first, while the throttle can still send
+	// or queue what they send
+	if(dispatcher)
+		dispatcher->stop();
+	// Messages still waiting for their turn are discarded rather than sent as the sessions
+	// log out; from here on those that would have to wait are discarded as they are sent
+	throttle->stop();
 	initiator->stop();
 	delete initiator;
+	delete dispatcher;
+	dispatcher = NULL;
+	delete quote_cache;
+	quote_cache = NULL;
+	delete subscriptions;
+	subscriptions = NULL;
+	delete throttle;
+	throttle = NULL;
 	delete settings;
 	delete store_factory;
 	delete log_factory;
@@ -294,7 +523,7 @@ void FixApplication::GetTradingStatus()
 	request.setField(TradSesReqID(NextRequestID()));
 	request.setField(TradingSessionID("FXCM"));
 	request.setField(SubscriptionRequestType(SubscriptionRequestType_SNAPSHOT));
-	Session::sendToTarget(request, sessionID(false));
+	throttle->send(request, sessionID(false));
 }
 
 // Sends the CollateralInquiry message in order to receive as a response the
@@ -302,12 +531,14 @@ void FixApplication::GetTradingStatus()
 void FixApplication::GetAccounts()
 {
 	// Request CollateralReport message. We will receive a CollateralReport for each
-	// account under our login
+	// account under our login, and then another one whenever an account changes
+	if(!accounts.startSubscription())
+		return;
 	FIX44::CollateralInquiry request;
 	request.setField(CollInquiryID(NextRequestID()));
 	request.setField(TradingSessionID("FXCM"));
-	request.setField(SubscriptionRequestType(SubscriptionRequestType_SNAPSHOT));
-	Session::sendToTarget(request, sessionID(false));
+	request.setField(SubscriptionRequestType(SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES));
+	throttle->send(request, sessionID(false));
 }
 
 // Sends RequestForPositions which will return PositionReport messages if positions
@@ -316,115 +547,85 @@ void FixApplication::GetAccounts()
 // positions for all accounts under our login
 void FixApplication::GetPositions()
 {
-	// Here we will get positions for each account under our login. To do this,
+	// Here we will subscribe to positions for each account under our login. To do this,
 	// we will send a RequestForPositions message that contains the accountID 
-	// associated with our request. For each account in our list, we send
-	// RequestForPositions. 
-	int total_accounts = (int)list_accountID.size();
+	// associated with our request. For each account in our list that is not subscribed
+	// yet, we send RequestForPositions. After the snapshot of open positions, the
+	// subscription keeps sending a PositionReport whenever a position changes
+	vector<string> account_IDs = accounts.getAccountIDs();
+	int total_accounts = (int)account_IDs.size();
 	for(int i = 0; i < total_accounts; i++){
-		string accountID = list_accountID.at(i);
-		// Set default fields
-		FIX44::RequestForPositions request;
-		request.setField(PosReqID(NextRequestID()));
-		request.setField(PosReqType(PosReqType_POSITIONS));
+		string accountID = account_IDs.at(i);
+		if(!position_keeper.startSubscription(accountID))
+			continue;
+		positions_request.set(PosReqID(NextRequestID()));
 		// AccountID for the request. This must be set for routing purposes. We must
 		// also set the Parties AccountID field in the NoPartySubIDs group
-		request.setField(Account(accountID)); 
-		request.setField(SubscriptionRequestType(SubscriptionRequestType_SNAPSHOT));
-		request.setField(AccountType(
-			AccountType_ACCOUNT_IS_CARRIED_ON_NON_CUSTOMER_SIDE_OF_BOOKS_AND_IS_CROSS_MARGINED));
-		request.setField(TransactTime());
-		request.setField(ClearingBusinessDate());
-		request.setField(TradingSessionID("FXCM"));
-		// Set NoPartyIDs group. These values are always as seen below
-		request.setField(NoPartyIDs(1));
-		FIX44::RequestForPositions::NoPartyIDs parties_group;
-		parties_group.setField(PartyID("FXCM ID"));
-		parties_group.setField(PartyIDSource('D'));
-		parties_group.setField(PartyRole(3));
-		parties_group.setField(NoPartySubIDs(1));
-		// Set NoPartySubIDs group
-		FIX44::RequestForPositions::NoPartyIDs::NoPartySubIDs sub_parties;
-		sub_parties.setField(PartySubIDType(PartySubIDType_SECURITIES_ACCOUNT_NUMBER));
-		// Set Parties AccountID
-		sub_parties.setField(PartySubID(accountID));
-		// Add NoPartySubIds group
-		parties_group.addGroup(sub_parties);
-		// Add NoPartyIDs group
-		request.addGroup(parties_group);
-		// Send request
-		Session::sendToTarget(request, sessionID(false));
+		positions_request.set(Account(accountID));
+		positions_request.set(CurrentTransactTime());
+		positions_request.set(ClearingBusinessDate());
+		positions_request.group(1, FIELD::NoPartyIDs)
+			.getGroupRef(1, FIELD::NoPartySubIDs).setField(PartySubID(accountID));
+		// Send request. With many accounts some of them wait in the outbound queue
+		positions_request.send(* throttle, sessionID(false));
+	}
+	ReportQueueDepth(sessionID(false));
+
+	// Print the positions we know of so far, with their profit or loss at the last quote
+	for(int i = 0; i < total_accounts; i++){
+		vector<Position> account_positions = position_keeper.getPositions(account_IDs.at(i));
+		for(size_t id = 0; id < account_positions.size(); id++){
+			const Position& position = account_positions[id];
+			if(position.tickets == 0)
+				continue;
+			cout << "Position -> Account - " << account_IDs.at(i)
+				<< " Symbol - " << instruments.get((int)id)->symbol
+				<< " Net - " << position.netQty()
+				<< " Unrealized P&L - " << position.unrealized_pnl << endl;
+		}
 	}
 }
 
-// Subscribes to the EUR/USD trading security
+// Subscribes to market data for strPair
 void FixApplication::SubscribeMarketData(string strPair)
 {
-	// Subscribe to market data for EUR/USD
-	string request_ID = strPair + "_Request_";
-	FIX44::MarketDataRequest request;
-	request.setField(MDReqID(request_ID));
-	request.setField(SubscriptionRequestType(
-		SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES));
-	request.setField(MarketDepth(0));
-	request.setField(NoRelatedSym(1));
-
-	// Add the NoRelatedSym group to the request with Symbol
-	// field set to EUR/USD
-	FIX44::MarketDataRequest::NoRelatedSym symbols_group;
-	symbols_group.setField(Symbol(strPair));
-	request.addGroup(symbols_group);
-
-	// Add the NoMDEntryTypes group to the request for each MDEntryType
-	// that we are subscribing to. This includes Bid, Offer, High, and Low
-	FIX44::MarketDataRequest::NoMDEntryTypes entry_types;
-	entry_types.setField(MDEntryType(MDEntryType_BID));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_OFFER));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_HIGH_PRICE));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_LOW_PRICE));
-	request.addGroup(entry_types);
-
-	Session::sendToTarget(request, sessionID(true));
-}
-
-// Unsubscribes from the EUR/USD trading security 
+	SubscribeMarketData(vector<string>(1, strPair));
+}
+
+void FixApplication::SubscribeMarketData(int instrument_ID)
+{
+	const Instrument* instrument = instruments.get(instrument_ID);
+	if(instrument)
+		SubscribeMarketData(instrument->symbol);
+}
+
+// The symbols go out in as few MarketDataRequests as possible, each carrying many
+// NoRelatedSym groups and asking for Bid, Offer, High, and Low
+void FixApplication::SubscribeMarketData(const vector<string>& symbols)
+{
+	subscriptions->subscribe(symbols, sessionID(true));
+}
+
+void FixApplication::SubscribeAllMarketData()
+{
+	vector<string> symbols;
+	for(size_t i = 0; i < instruments.size(); i++)
+		symbols.push_back(instruments.get((int)i)->symbol);
+	SubscribeMarketData(symbols);
+}
+
+// Note that a subscription can only be cancelled with the exact MDReqID it was made
+// with. The request to unsubscribe is identical to the request to subscribe with the
+// exception that SubscriptionRequestType is set to
+// "SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST"
+void FixApplication::UnsubscribeMarketData(const vector<string>& symbols)
+{
+	subscriptions->unsubscribe(symbols, sessionID(true));
+}
+
 void FixApplication::UnsubscribeMarketData()
 {
-	// Unsubscribe from EUR/USD. Note that our request_ID is the exact same
-	// that was sent for our request to subscribe. This is necessary to 
-	// unsubscribe. This request below is identical to our request to subscribe
-	// with the exception that SubscriptionRequestType is set to
-	// "SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST"
-	string request_ID = "EUR_USD_Request_";
-	FIX44::MarketDataRequest request;
-	request.setField(MDReqID(request_ID));
-	request.setField(SubscriptionRequestType(
-		SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST));
-	request.setField(MarketDepth(0));
-	request.setField(NoRelatedSym(1));
-
-	// Add the NoRelatedSym group to the request with Symbol
-	// field set to EUR/USD
-	FIX44::MarketDataRequest::NoRelatedSym symbols_group;
-	symbols_group.setField(Symbol("EUR/USD"));
-	request.addGroup(symbols_group);
-
-	// Add the NoMDEntryTypes group to the request for each MDEntryType
-	// that we are subscribing to. This includes Bid, Offer, High, and Low
-	FIX44::MarketDataRequest::NoMDEntryTypes entry_types;
-	entry_types.setField(MDEntryType(MDEntryType_BID));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_OFFER));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_HIGH_PRICE));
-	request.addGroup(entry_types);
-	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_LOW_PRICE));
-	request.addGroup(entry_types);
-
-	Session::sendToTarget(request, sessionID(true));
+	subscriptions->unsubscribeAll(sessionID(true));
 }
 
 // Sends a basic NewOrderSingle message to buy EUR/USD at the 
@@ -434,49 +635,62 @@ void FixApplication::MarketOrder()
 	// For each account in our list, send a NewOrderSingle message
 	// to buy EUR/USD. What differentiates this message is the
 	// accountID
-	int total_accounts = (int)list_accountID.size();
+	vector<string> account_IDs = accounts.getAccountIDs();
+	int total_accounts = (int)account_IDs.size();
 	for(int i = 0; i < total_accounts; i++){
-		string accountID = list_accountID.at(i);
-		FIX44::NewOrderSingle request;
-		request.setField(ClOrdID(NextRequestID()));	
-		request.setField(Account(accountID));
-		request.setField(Symbol("EUR/USD"));
-		request.setField(TradingSessionID("FXCM"));
-		request.setField(TransactTime());
-		request.setField(OrderQty(10000));
-		request.setField(Side(FIX::Side_BUY));
-		request.setField(OrdType(OrdType_MARKET));
-		request.setField(TimeInForce(FIX::TimeInForce_GOOD_TILL_CANCEL)); // For newer versions of QuickFIX change this to TimeInForce_GOOD_TILL_CANCEL
-		Session::sendToTarget(request, sessionID(false));
+		string accountID = account_IDs.at(i);
+		if(!CheckOrder(accountID, "EUR/USD", 10000))
+			continue;
+		string cl_ord_ID = NextRequestID();
+		if(!orders.addOrder(cl_ord_ID, accountID, "EUR/USD", Side_BUY, 10000)){
+			cout << "Order -> ClOrdID " << cl_ord_ID << " is already in use, not sent" << endl;
+			continue;
+		}
+		market_order.set(ClOrdID(cl_ord_ID));
+		market_order.set(Account(accountID));
+		market_order.set(CurrentTransactTime());
+		market_order.send(* throttle, sessionID(false));
 	}
+	ReportQueueDepth(sessionID(false));
 }
 
-// Generate string value used to populate the fields in each message
-// which are used as a custom identifier
-string FixApplication::NextRequestID()
+// Runs the pre-trade risk checks on an order before it is built and sent. The exposure
+// checked against the position limit is the account's net position in the instrument
+// plus everything it has working, whichever way those orders go
+bool FixApplication::CheckOrder(const string& account, const string& symbol, double quantity)
 {
-	if(requestID == 65535)
-		requestID = 1;
+	int instrument_ID = instruments.id(symbol);
+	double exposure = fabs(position_keeper.getPosition(account, instrument_ID).netQty())
+		+ orders.getTotals(account, instrument_ID).working_qty;
+	RiskGate::Result result = risk_gate.check(account, instrument_ID, quantity, exposure);
+	if(result == RiskGate::ACCEPTED)
+		return true;
+	cout << "Order refused -> Account - " << account << " Symbol - " << symbol
+		<< " Quantity - " << quantity << " - " << RiskGate::describe(result) << endl;
+	return false;
+}
 
-	requestID++;
-	string next_ID = IntConvertor::convert(requestID);
-	return next_ID;
+// Tells how many messages are still waiting for ThrottleRate to let them out
+void FixApplication::ReportQueueDepth(const SessionID& session_ID)
+{
+	size_t depth = throttle->depth(session_ID);
+	if(depth)
+		cout << "Outbound queue -> " << depth << " messages waiting" << endl;
 }
 
-// Adds string accountIDs to our vector<string> being used to
-// account for the accountIDs under our login
-void FixApplication::RecordAccount(string accountID)
+// Current time from the configured clock as a TransactTime field. Only the
+// command thread sends requests, so the formatter is not shared
+FieldBase FixApplication::CurrentTransactTime()
 {
-	int size = (int)list_accountID.size();
-	if(size == 0){
-		list_accountID.push_back(accountID);
-	}else{
-		for(int i = 0; i < size; i++){
-			if(list_accountID.at(i) == accountID)
-				break;
-			if(i == size - 1){
-				list_accountID.push_back(accountID);
-			}
-		}
-	}
-}
\ No newline at end of file
+	return FieldBase(FIELD::TransactTime, transact_time_format.format(clock->now()));
+}
+
+// Generate string value used to populate the fields in each message
+// which are used as a custom identifier
+string FixApplication::NextRequestID()
+{
+	int id = requestID.fetch_add(1) + 1;
+	char buffer[FastIntConvertor::MAX_CHARS];
+	char* end = FastIntConvertor::toChars(buffer, buffer + sizeof(buffer), id);
+	return string(buffer, end);
+}
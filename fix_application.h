@@ -1,7 +1,10 @@
 #ifndef FIXAPPLICATION_H
 #define FIXAPPLICATION_H
 
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <map>
 #include <vector>
 #include "quickfix\Application.h"
 #include "quickfix\FileLog.h"
@@ -25,7 +28,23 @@
 #include "quickfix\Session.h"
 #include "quickfix\SessionID.h"
 #include "quickfix\SessionSettings.h"
-#include "quickfix\SocketInitiator.h"
+#include "account_store.h"
+#include "cached_file_log.h"
+#include "fast_socket_connection.h"
+#include "fast_socket_initiator.h"
+#include "message_dispatcher.h"
+#include "fast_convertors.h"
+#include "instrument_registry.h"
+#include "message_template.h"
+#include "order_book.h"
+#include "outbound_throttle.h"
+#include "position_keeper.h"
+#include "raw_message.h"
+#include "quote_cache.h"
+#include "risk_gate.h"
+#include "subscription_manager.h"
+#include "fixed_price.h"
+#include "utc_clock.h"
 
 using namespace std;
 using namespace FIX;
@@ -33,16 +52,61 @@ using namespace FIX;
 class FixApplication : public MessageCracker, public Application
 {
 private:
-	SessionSettings  *settings;
-	FileStoreFactory *store_factory;
-	FileLogFactory   *log_factory;
-	SocketInitiator  *initiator;
+	SessionSettings      *settings;
+	FileStoreFactory     *store_factory;
+	CachedFileLogFactory *log_factory;
+	Initiator            *initiator;
+	// Cracks application messages on a thread of its own when AppQueue=Y;
+	// NULL to crack them on the socket threads
+	MessageDispatcher    *dispatcher;
+	// Time source shared by the logs and the TransactTime of our requests;
+	// selected with the ClockSource setting. TransactTime has as many fractional
+	// digits as the log timestamps (TimestampPrecision)
+	const Clock *clock;
+	TimestampFormatter transact_time_format;
+	// TransactTime field with the current time, formatted by transact_time_format
+	FieldBase CurrentTransactTime();
 
-	// Used as a counter for producing unique request identifiers
-	unsigned int requestID;
+	// Used as a counter for producing unique request identifiers. Taken from the socket
+	// threads (GetTradingStatus on logon) as well as the command thread, and never
+	// wrapped, since the order book tells orders apart by their ClOrdID
+	atomic<int> requestID;
 	SessionID sessionID(bool md);
 	vector<SessionID> sessions;
-	vector<string> list_accountID;
+	// Accounts under our login with their balance and margin, from the CollateralReports
+	AccountStore accounts;
+	// Instruments of the SecurityList with their dense IDs, precision and quantity limits
+	InstrumentRegistry instruments;
+	// Our open orders, from the ExecutionReports
+	OrderBook orders;
+	// Open positions of each account from the PositionReports, marked to market on each quote
+	PositionKeeper position_keeper;
+	// Pre-trade checks every order passes before it is sent, with the limits of the
+	// SecurityList and of the Risk settings
+	RiskGate risk_gate;
+	bool CheckOrder(const string& account, const string& symbol, double quantity);
+	// Latest quote of each instrument, updated by fromApp as snapshots arrive
+	QuoteCache *quote_cache;
+	static const int DEFAULT_QUOTE_CACHE_SIZE = 1024;
+	void UpdateQuote(const RawMessage& snapshot);
+	// The wire form of a message fromApp is handling, read off the receive buffer of
+	// its FastSocketConnection where possible and rendered again otherwise. Reused by
+	// each socket thread, so valid until its next call on that thread
+	static const RawMessage& WireForm(const Message& message);
+	// Market data subscriptions of the MD session, sent in batches of MarketDataBatchSize
+	// and sent again after each logon
+	SubscriptionManager *subscriptions;
+	static bool IsMarketDataSession(const SessionID& session_ID);
+	// Application messages we send go through it, so that bursts over many accounts
+	// or symbols stay within ThrottleRate of each session
+	OutboundThrottle *throttle;
+	void ReportQueueDepth(const SessionID& session_ID);
+
+	// Outbound messages built once in BuildTemplates; each request only overwrites
+	// its variable fields. Used from the command thread only
+	MessageTemplate<FIX44::NewOrderSingle>      market_order;
+	MessageTemplate<FIX44::RequestForPositions> positions_request;
+	void BuildTemplates();
 
 	// Custom FXCM FIX fields
 	enum FXCM_FIX_FIELDS
@@ -96,21 +160,44 @@ public:
 	void StartSession();
 	// Logout and end session 
 	void EndSession();
+	// Latest quotes by symbol, readable from any thread without locking. NULL
+	// before StartSession
+	const QuoteCache* Quotes() const { return quote_cache; }
+	// Symbol to instrument ID resolution, also from any thread. Quotes are kept by
+	// instrument ID
+	const InstrumentRegistry& Instruments() const { return instruments; }
+	// Open orders and working and filled quantities per account and instrument;
+	// add an OrderListener to hear of orders as they are done
+	OrderBook& Orders() { return orders; }
+	// Positions and unrealized P&L per account and instrument, current as of the last quote
+	const PositionKeeper& Positions() const { return position_keeper; }
+	// Order limits per instrument and account, and the kill switch
+	RiskGate& Risk() { return risk_gate; }
+	// Messages waiting for their turn to be sent, per session. NULL before StartSession
+	const OutboundThrottle* Throttle() const { return throttle; }
 
 	// Sends TradingSessionStatusRequest message in order to receive as a response the
 	// TradingSessionStatus message
 	void GetTradingStatus();
 	// Sends the CollateralInquiry message in order to receive as a response the
-	// CollateralReport message.
+	// CollateralReport message, and after it a CollateralReport for each change of an account.
+	// Only sent once per logon
 	void GetAccounts();
-	// Sends RequestForPositions which will return PositionReport messages if positions
-	// matching the requested criteria exist; otherwise, a RequestForPositionsAck will be
-	// sent with the acknowledgement that no positions exist. In our example, we request
-	// positions for all accounts under our login
+	// Subscribes with RequestForPositions to the positions of each account under our login
+	// that is not subscribed yet, which returns PositionReport messages for the open
+	// positions and then for each change; a RequestForPositionsAck tells if there are none.
+	// Then prints the positions known so far
 	void GetPositions();
-	// Subscribes to the EUR/USD trading security
+	// Subscribes to trading securities, as many per MarketDataRequest as
+	// MarketDataBatchSize allows. Symbols already subscribed are skipped
 	void SubscribeMarketData(string strPair);
-	// Unsubscribes from the EUR/USD trading security 
+	void SubscribeMarketData(int instrument_ID);
+	void SubscribeMarketData(const vector<string>& symbols);
+	// Subscribes to every security of the SecurityList
+	void SubscribeAllMarketData();
+	// Unsubscribes from trading securities, or from all of them. Each request
+	// repeats the MDReqID the subscription was made with
+	void UnsubscribeMarketData(const vector<string>& symbols);
 	void UnsubscribeMarketData();
 	// Sends a basic NewOrderSingle message to buy EUR/USD at the 
 	// current market price
@@ -118,9 +205,9 @@ public:
 	// Generate string value used to populate the fields in each message
 	// which are used as a custom identifier
 	string NextRequestID();
-	// Adds string accountIDs to our vector<string> being used to
-	// account for the accountIDs under our login
-	void RecordAccount(string accountID);
+	// Balance, margin and parties of the accounts under our login; add an AccountListener
+	// to hear of margin changes
+	AccountStore& Accounts() { return accounts; }
 };
 
 #endif // FIXAPPLICATION_H
\ No newline at end of file
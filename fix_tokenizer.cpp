@@ -0,0 +1,242 @@
+#include "fix_tokenizer.h"
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TOKENIZER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+const char SOH = '\001';
+const int CHECKSUM_TAG = 10;
+
+// Index of the lowest set bit of a non-zero mask
+inline unsigned int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+#if defined(TOKENIZER_AVX2)
+const size_t BLOCK = 32;
+
+// Sums the block and sets a bit in mask for every '=' or SOH in it
+inline unsigned int scanBlock(const char* p, unsigned int& mask)
+{
+	__m256i block = _mm256_loadu_si256((const __m256i*)p);
+	__m256i delimiters = _mm256_or_si256(
+		_mm256_cmpeq_epi8(block, _mm256_set1_epi8('=')),
+		_mm256_cmpeq_epi8(block, _mm256_set1_epi8(SOH)));
+	mask = (unsigned int)_mm256_movemask_epi8(delimiters);
+	__m256i sums = _mm256_sad_epu8(block, _mm256_setzero_si256());
+	__m128i folded = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+	return (unsigned int)(_mm_cvtsi128_si32(folded) + _mm_extract_epi16(folded, 4));
+}
+
+inline unsigned int sumBlock(const char* p)
+{
+	__m256i sums = _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)p), _mm256_setzero_si256());
+	__m128i folded = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+	return (unsigned int)(_mm_cvtsi128_si32(folded) + _mm_extract_epi16(folded, 4));
+}
+#elif defined(TOKENIZER_SSE2)
+const size_t BLOCK = 16;
+
+// Sums the block and sets a bit in mask for every '=' or SOH in it
+inline unsigned int scanBlock(const char* p, unsigned int& mask)
+{
+	__m128i block = _mm_loadu_si128((const __m128i*)p);
+	__m128i delimiters = _mm_or_si128(
+		_mm_cmpeq_epi8(block, _mm_set1_epi8('=')),
+		_mm_cmpeq_epi8(block, _mm_set1_epi8(SOH)));
+	mask = (unsigned int)_mm_movemask_epi8(delimiters);
+	__m128i sums = _mm_sad_epu8(block, _mm_setzero_si128());
+	return (unsigned int)(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+}
+
+inline unsigned int sumBlock(const char* p)
+{
+	__m128i sums = _mm_sad_epu8(_mm_loadu_si128((const __m128i*)p), _mm_setzero_si128());
+	return (unsigned int)(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+}
+#endif
+
+// Turns delimiter positions into tokens. Inside a tag the next '=' ends it; inside a
+// value only SOH counts, so values may contain '='
+class TokenBuilder
+{
+public:
+	TokenBuilder(const char* data, FixTokenizer::Tokens& tokens)
+		: data(data), tokens(tokens), field_start(0), value_start(0), tag(0), in_tag(true)
+	{
+		tokens.clear();
+	}
+
+	bool delimiter(size_t position)
+	{
+		if(data[position] == '='){
+			if(!in_tag)
+				return true;
+			if(position == field_start)
+				return false;
+			tag = 0;
+			for(size_t i = field_start; i < position; i++){
+				unsigned int digit = (unsigned char)data[i] - '0';
+				if(digit > 9)
+					return false;
+				tag = tag * 10 + (int)digit;
+			}
+			value_start = position + 1;
+			in_tag = false;
+			return true;
+		}
+		if(in_tag)
+			return false;
+		FixTokenizer::Token token = { tag, (unsigned int)value_start, (unsigned int)(position - value_start) };
+		tokens.push_back(token);
+		field_start = position + 1;
+		in_tag = true;
+		return true;
+	}
+
+	// True when the input ended exactly on a field boundary
+	bool complete(size_t size) const { return in_tag && field_start == size; }
+
+private:
+	const char* data;
+	FixTokenizer::Tokens& tokens;
+	size_t field_start;
+	size_t value_start;
+	int tag;
+	bool in_tag;
+};
+
+// The CheckSum field itself is not part of the sum
+int finishCheckSum(unsigned int total, const char* data, size_t size, const FixTokenizer::Tokens& tokens)
+{
+	if(!tokens.empty() && tokens.back().tag == CHECKSUM_TAG){
+		for(size_t i = tokens.back().offset - 3; i < size; i++)
+			total -= (unsigned char)data[i];
+	}
+	return (int)(total % 256);
+}
+}
+
+bool FixTokenizer::tokenize(const char* data, size_t size, Tokens& tokens, int& checksum)
+{
+#if defined(TOKENIZER_AVX2) || defined(TOKENIZER_SSE2)
+	TokenBuilder builder(data, tokens);
+	unsigned int total = 0;
+	size_t i = 0;
+	for(; i + BLOCK <= size; i += BLOCK){
+		unsigned int mask;
+		total += scanBlock(data + i, mask);
+		while(mask){
+			if(!builder.delimiter(i + lowestBit(mask)))
+				return false;
+			mask &= mask - 1;
+		}
+	}
+	for(; i < size; i++){
+		total += (unsigned char)data[i];
+		if((data[i] == '=' || data[i] == SOH) && !builder.delimiter(i))
+			return false;
+	}
+	if(!builder.complete(size))
+		return false;
+	checksum = finishCheckSum(total, data, size, tokens);
+	return true;
+#else
+	return tokenizeScalar(data, size, tokens, checksum);
+#endif
+}
+
+bool FixTokenizer::tokenizeScalar(const char* data, size_t size, Tokens& tokens, int& checksum)
+{
+	TokenBuilder builder(data, tokens);
+	unsigned int total = 0;
+	for(size_t i = 0; i < size; i++){
+		total += (unsigned char)data[i];
+		if((data[i] == '=' || data[i] == SOH) && !builder.delimiter(i))
+			return false;
+	}
+	if(!builder.complete(size))
+		return false;
+	checksum = finishCheckSum(total, data, size, tokens);
+	return true;
+}
+
+unsigned int FixTokenizer::byteSum(const char* data, size_t size)
+{
+	unsigned int total = 0;
+	size_t i = 0;
+#if defined(TOKENIZER_AVX2) || defined(TOKENIZER_SSE2)
+	for(; i + BLOCK <= size; i += BLOCK)
+		total += sumBlock(data + i);
+#endif
+	for(; i < size; i++)
+		total += (unsigned char)data[i];
+	return total;
+}
+
+bool FixTokenizer::messageLength(const char* data, size_t size, size_t& length)
+{
+	size_t claimed;
+	return messageLength(data, size, length, claimed);
+}
+
+bool FixTokenizer::messageLength(const char* data, size_t size, size_t& length, size_t& claimed)
+{
+	length = 0;
+	claimed = 0;
+	const char* end = data + size;
+	if(size >= 1 && data[0] != '8')
+		return false;
+	if(size >= 2 && data[1] != '=')
+		return false;
+	const char* soh = (const char*)memchr(data, SOH, size);
+	if(soh == NULL)
+		return true;
+
+	const char* p = soh + 1;
+	if(p < end && *p != '9')
+		return false;
+	if(p + 1 < end && p[1] != '=')
+		return false;
+	if(end - p < 2)
+		return true;
+	p += 2;
+	const char* digits = p;
+	size_t body = 0;
+	while(p < end && *p >= '0' && *p <= '9'){
+		// More digits than any real message needs; checked before multiplying so
+		// that a long run of garbage digits cannot wrap into a small length
+		if(p - digits == MAX_BODY_LENGTH_DIGITS)
+			return false;
+		body = body * 10 + (size_t)(*p++ - '0');
+	}
+	if(p == end)
+		return true;
+	if(*p != SOH || p == digits)
+		return false;
+
+	// Header up to and including the SOH after BodyLength, the body, then 10=nnn<SOH>
+	size_t total = (size_t)(p + 1 - data) + body + 7;
+	claimed = total;
+	if(total <= size)
+		length = total;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef FIXTOKENIZER_H
+#define FIXTOKENIZER_H
+
+#include <cstddef>
+#include "small_vector.h"
+
+// Single pass FIX tokenizer. One scan over the raw bytes finds every '=' and SOH
+// boundary, produces a (tag, offset, length) table and sums the bytes for the
+// CheckSum(10) field at the same time. The scan runs 32 bytes at a time with AVX2
+// or 16 bytes at a time with SSE2, whichever the build targets (/arch:AVX2 selects
+// AVX2; x64 always has SSE2), and falls back to a plain byte loop otherwise.
+class FixTokenizer
+{
+public:
+	struct Token
+	{
+		int tag;
+		unsigned int offset;
+		unsigned int length;
+	};
+
+	// Inline capacity; large enough for a snapshot with its four MDEntries
+	enum { INLINE_TOKENS = 96 };
+	typedef SmallVector<Token, INLINE_TOKENS> Tokens;
+
+	// Fills tokens with one entry per tag=value<SOH> field of [data, data + size) and
+	// stores the checksum (byte sum modulo 256 of everything before a trailing
+	// CheckSum field). Returns false if the bytes are not a sequence of complete
+	// fields. A '=' inside a value is part of the value, as on the wire.
+	static bool tokenize(const char* data, size_t size, Tokens& tokens, int& checksum);
+	// Same result as tokenize without vector instructions
+	static bool tokenizeScalar(const char* data, size_t size, Tokens& tokens, int& checksum);
+
+	// Sum of all bytes, the basis of CheckSum(10)
+	static unsigned int byteSum(const char* data, size_t size);
+
+	// BodyLength of up to 99,999,999 bytes
+	enum { MAX_BODY_LENGTH_DIGITS = 8 };
+
+	// Frames the first message of a receive buffer the way Parser::extractLength does:
+	// reads BodyLength(9) and adds the header and the 7 byte CheckSum field. Sets
+	// length to 0 if the message is not complete yet. Returns false if the buffer
+	// does not start with BeginString and BodyLength, or if BodyLength has more than
+	// MAX_BODY_LENGTH_DIGITS digits.
+	static bool messageLength(const char* data, size_t size, size_t& length);
+	// Also sets claimed to the length BodyLength gives the message as soon as it has
+	// been read, complete or not; 0 before that
+	static bool messageLength(const char* data, size_t size, size_t& length, size_t& claimed);
+};
+
+#endif // FIXTOKENIZER_H
\ No newline at end of file
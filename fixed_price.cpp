@@ -0,0 +1,129 @@
+#include "fixed_price.h"
+
+namespace
+{
+const long long POW10[] = {
+	1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+	1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+	100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+	1000000000000000000LL
+};
+}
+
+bool FixedPrice::parse(const char* first, const char* last, int digits, FixedPrice& price)
+{
+	if(digits < 0 || digits > MAX_DIGITS)
+		return false;
+	const char* p = first;
+	bool negative = p < last && *p == '-';
+	if(negative)
+		p++;
+
+	unsigned long long units = 0;
+	int decimals = -1; // -1 until the point is seen
+	bool any_digit = false;
+	// First decimal beyond the precision, which decides the rounding
+	int round_digit = -1;
+	for(; p < last; p++){
+		if(*p == '.'){
+			if(decimals >= 0)
+				return false;
+			decimals = 0;
+			continue;
+		}
+		unsigned int digit = (unsigned char)*p - '0';
+		if(digit > 9)
+			return false;
+		any_digit = true;
+		if(decimals >= digits){
+			if(round_digit < 0)
+				round_digit = (int)digit;
+			continue;
+		}
+		if(decimals >= 0)
+			decimals++;
+		if(units > 922337203685477580ULL)
+			return false;
+		units = units * 10 + digit;
+	}
+	if(!any_digit)
+		return false;
+	if(decimals < 0)
+		decimals = 0;
+	unsigned long long scale = (unsigned long long)POW10[digits - decimals];
+	if(units > 9223372036854775807ULL / scale)
+		return false;
+	units *= scale;
+	// Half away from zero, like the fractional pips FXCM quotes beyond the precision
+	if(round_digit >= 5){
+		if(units == 9223372036854775807ULL)
+			return false;
+		units++;
+	}
+	price = FixedPrice(negative ? -(long long)units : (long long)units, digits);
+	return true;
+}
+
+char* FixedPrice::format(char* first, char* last) const
+{
+	bool negative = units < 0;
+	unsigned long long magnitude = negative ? 0ULL - (unsigned long long)units : (unsigned long long)units;
+	int length = 1;
+	for(unsigned long long rest = magnitude / 10; rest != 0; rest /= 10)
+		length++;
+	if(length <= digits)
+		length = digits + 1; // leading "0."
+	length += (negative ? 1 : 0) + (digits > 0 ? 1 : 0);
+	if(last - first < length)
+		return NULL;
+
+	char* p = first + length;
+	for(int i = 0; i < digits; i++){
+		*--p = (char)('0' + magnitude % 10);
+		magnitude /= 10;
+	}
+	if(digits > 0)
+		*--p = '.';
+	do{
+		*--p = (char)('0' + magnitude % 10);
+		magnitude /= 10;
+	}while(magnitude != 0);
+	if(negative)
+		*--p = '-';
+	return first + length;
+}
+
+string FixedPrice::toString() const
+{
+	char buffer[MAX_CHARS];
+	char* end = format(buffer, buffer + sizeof(buffer));
+	return string(buffer, end);
+}
+
+double FixedPrice::toDouble() const
+{
+	// Integer / exact power of ten, correctly rounded
+	return (double)units / (double)POW10[digits];
+}
+
+FixedPrice getPrice(const FieldMap& map, int field, int digits)
+{
+	const string& text = map.getField(field);
+	FixedPrice price;
+	if(!FixedPrice::parse(text, digits, price))
+		throw IncorrectDataFormat(field, text);
+	return price;
+}
+
+bool getPriceIfSet(const FieldMap& map, int field, int digits, FixedPrice& price)
+{
+	if(!map.isSetField(field))
+		return false;
+	price = getPrice(map, field, digits);
+	return true;
+}
+
+void setPrice(FieldMap& map, int field, const FixedPrice& price)
+{
+	map.setField(field, price.toString());
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef FIXEDPRICE_H
+#define FIXEDPRICE_H
+
+#include <string>
+#include "quickfix\FieldMap.h"
+
+using namespace std;
+using namespace FIX;
+
+// A price kept as a scaled integer: the value is units / 10^digits. digits is the
+// symbol's precision as FXCM reports it in the SecurityList (FXCM_SYM_PRECISION,
+// 9001), so 1.08345 on EUR/USD (precision 5) is 108345 units. Parsing and
+// formatting go straight between the wire text and the integer, without floating
+// point, and comparing or subtracting two prices of one symbol is exact.
+class FixedPrice
+{
+public:
+	// Largest precision supported; 10^18 still fits the units
+	enum { MAX_DIGITS = 18 };
+	// Longest text: sign, 19 digits and a point
+	enum { MAX_CHARS = 21 };
+
+	FixedPrice() : units(0), digits(0) {}
+	FixedPrice(long long units, int digits) : units(units), digits(digits) {}
+
+	// Parses a FIX price with the given precision. Fewer decimals than digits are
+	// padded; more, such as the fractional pips FXCM may send, are rounded half away
+	// from zero
+	static bool parse(const char* first, const char* last, int digits, FixedPrice& price);
+	static bool parse(const string& text, int digits, FixedPrice& price)
+	{ return parse(text.data(), text.data() + text.size(), digits, price); }
+
+	// Writes the price with exactly digits decimals; returns one past the last
+	// character, or NULL if it does not fit
+	char* format(char* first, char* last) const;
+	string toString() const;
+	double toDouble() const;
+
+	long long getUnits() const { return units; }
+	int getDigits() const { return digits; }
+
+	// Comparisons and arithmetic expect both prices to have the same digits
+	bool operator==(const FixedPrice& rhs) const { return units == rhs.units; }
+	bool operator!=(const FixedPrice& rhs) const { return units != rhs.units; }
+	bool operator<(const FixedPrice& rhs) const { return units < rhs.units; }
+	bool operator>(const FixedPrice& rhs) const { return units > rhs.units; }
+	FixedPrice operator-(const FixedPrice& rhs) const { return FixedPrice(units - rhs.units, digits); }
+	FixedPrice operator+(const FixedPrice& rhs) const { return FixedPrice(units + rhs.units, digits); }
+
+private:
+	long long units;
+	int digits;
+};
+
+// Price accessors for message and group classes, e.g. MDEntryPx(270) of a
+// FIX44::MarketDataSnapshotFullRefresh::NoMDEntries or Price(44) of a
+// FIX44::NewOrderSingle. getPrice throws FieldNotFound if the field is missing
+// and IncorrectDataFormat if it is not a number or the precision is over MAX_DIGITS
+FixedPrice getPrice(const FieldMap& map, int field, int digits);
+bool getPriceIfSet(const FieldMap& map, int field, int digits, FixedPrice& price);
+void setPrice(FieldMap& map, int field, const FixedPrice& price);
+
+#endif // FIXEDPRICE_H
\ No newline at end of file
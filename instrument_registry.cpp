@@ -0,0 +1,190 @@
+#include "instrument_registry.h"
+#include <algorithm>
+#include <map>
+#include "quickfix\FieldConvertors.h"
+#include "quickfix\fix44\SecurityList.h"
+
+namespace
+{
+// Seeds tried for one bucket before the slot table is doubled
+const unsigned int MAX_SEED = 4096;
+
+unsigned int roundUpToPowerOfTwo(size_t value)
+{
+	unsigned int result = 1;
+	while(result < value)
+		result *= 2;
+	return result;
+}
+
+// Orders buckets from the fullest, which are the hardest to place
+struct ByMemberCount
+{
+	const vector<vector<int> >& members;
+	explicit ByMemberCount(const vector<vector<int> >& members) : members(members) {}
+	bool operator()(unsigned int a, unsigned int b) const { return members[a].size() > members[b].size(); }
+};
+}
+
+InstrumentRegistry::InstrumentRegistry()
+{
+	Table* empty = new Table();
+	buildHash(*empty);
+	table.store(empty);
+}
+
+InstrumentRegistry::~InstrumentRegistry()
+{
+	delete table.load();
+	for(size_t i = 0; i < retired.size(); i++)
+		delete retired[i];
+}
+
+size_t InstrumentRegistry::update(const FieldMap& security_list)
+{
+	Locker locker(mutex);
+	const Table* current = table.load(memory_order_relaxed);
+	Table* next = new Table(*current);
+	try{
+		// Symbols new in this update, which the current hash does not know yet
+		map<string, int> added;
+		int count = IntConvertor::convert(security_list.getField(FIELD::NoRelatedSym));
+		FIX44::SecurityList::NoRelatedSym group;
+		for(int i = 1; i <= count; i++){
+			security_list.getGroup(i, FIELD::NoRelatedSym, group);
+			Instrument instrument = Instrument();
+			instrument.symbol = group.getField(FIELD::Symbol);
+			instrument.digits = DEFAULT_DIGITS;
+			if(group.isSetField(FXCM_SYM_ID))
+				instrument.fxcm_sym_id = group.getField(FXCM_SYM_ID);
+			if(group.isSetField(FXCM_SYM_PRECISION))
+				instrument.digits = IntConvertor::convert(group.getField(FXCM_SYM_PRECISION));
+			if(group.isSetField(FXCM_SYM_POINT_SIZE))
+				instrument.point_size = DoubleConvertor::convert(group.getField(FXCM_SYM_POINT_SIZE));
+			if(group.isSetField(FXCM_MIN_QUANTITY))
+				instrument.min_quantity = DoubleConvertor::convert(group.getField(FXCM_MIN_QUANTITY));
+			if(group.isSetField(FXCM_MAX_QUANTITY))
+				instrument.max_quantity = DoubleConvertor::convert(group.getField(FXCM_MAX_QUANTITY));
+
+			instrument.id = lookup(*current, instrument.symbol);
+			if(instrument.id < 0){
+				map<string, int>::const_iterator j = added.find(instrument.symbol);
+				instrument.id = j != added.end() ? j->second : (int)next->instruments.size();
+			}
+			if(instrument.id == (int)next->instruments.size()){
+				added[instrument.symbol] = instrument.id;
+				next->instruments.push_back(instrument);
+			}else{
+				next->instruments[instrument.id] = instrument;
+			}
+		}
+		buildHash(*next);
+	}catch(...){
+		delete next;
+		throw;
+	}
+	retired.push_back(current);
+	table.store(next, memory_order_release);
+	return next->instruments.size();
+}
+
+int InstrumentRegistry::id(const string& symbol) const
+{
+	return lookup(*table.load(memory_order_acquire), symbol);
+}
+
+const Instrument* InstrumentRegistry::find(const string& symbol) const
+{
+	const Table& current = *table.load(memory_order_acquire);
+	int number = lookup(current, symbol);
+	return number < 0 ? NULL : &current.instruments[number];
+}
+
+const Instrument* InstrumentRegistry::get(int id) const
+{
+	const Table& current = *table.load(memory_order_acquire);
+	if(id < 0 || id >= (int)current.instruments.size())
+		return NULL;
+	return &current.instruments[id];
+}
+
+size_t InstrumentRegistry::size() const
+{
+	return table.load(memory_order_acquire)->instruments.size();
+}
+
+int InstrumentRegistry::lookup(const Table& table, const string& symbol)
+{
+	unsigned int bucket = hash(symbol, 0) & table.bucket_mask;
+	int number = table.slots[hash(symbol, table.seeds[bucket]) & table.slot_mask];
+	if(number < 0 || table.instruments[number].symbol != symbol)
+		return -1;
+	return number;
+}
+
+// FNV-1a with the seed folded into the offset basis, then the MurmurHash3
+// finalizer so that the low bits used for the masks are well mixed
+unsigned int InstrumentRegistry::hash(const string& symbol, unsigned int seed)
+{
+	unsigned int h = 2166136261u ^ (seed * 0x9E3779B9u);
+	for(size_t i = 0; i < symbol.size(); i++){
+		h ^= (unsigned char)symbol[i];
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+// Hash and displace: symbols are split into about two per bucket, and the
+// buckets, fullest first, each search for a seed that puts all their symbols in
+// free slots. With twice as many slots as symbols a seed is found after a few
+// tries; if one bucket runs out of seeds the slot table is doubled
+void InstrumentRegistry::buildHash(Table& table)
+{
+	size_t count = table.instruments.size();
+	unsigned int bucket_count = roundUpToPowerOfTwo(count / 2);
+	unsigned int slot_count = roundUpToPowerOfTwo(count * 2);
+	table.bucket_mask = bucket_count - 1;
+
+	vector<vector<int> > members(bucket_count);
+	for(size_t i = 0; i < count; i++)
+		members[hash(table.instruments[i].symbol, 0) & table.bucket_mask].push_back((int)i);
+	vector<unsigned int> order(bucket_count);
+	for(unsigned int i = 0; i < bucket_count; i++)
+		order[i] = i;
+	sort(order.begin(), order.end(), ByMemberCount(members));
+
+	vector<unsigned int> positions;
+	for(;;){
+		table.slot_mask = slot_count - 1;
+		table.slots.assign(slot_count, -1);
+		table.seeds.assign(bucket_count, 0);
+		bool placed = true;
+		for(unsigned int i = 0; i < bucket_count && placed && !members[order[i]].empty(); i++){
+			const vector<int>& bucket = members[order[i]];
+			placed = false;
+			for(unsigned int seed = 1; seed < MAX_SEED && !placed; seed++){
+				positions.clear();
+				placed = true;
+				for(size_t j = 0; j < bucket.size() && placed; j++){
+					unsigned int position = hash(table.instruments[bucket[j]].symbol, seed) & table.slot_mask;
+					placed = table.slots[position] < 0
+						&& std::find(positions.begin(), positions.end(), position) == positions.end();
+					positions.push_back(position);
+				}
+				if(placed){
+					for(size_t j = 0; j < bucket.size(); j++)
+						table.slots[positions[j]] = bucket[j];
+					table.seeds[order[i]] = seed;
+				}
+			}
+		}
+		if(placed)
+			return;
+		slot_count *= 2;
+	}
+}
@@ -0,0 +1,93 @@
+#ifndef INSTRUMENTREGISTRY_H
+#define INSTRUMENTREGISTRY_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "quickfix\FieldMap.h"
+#include "quickfix\Mutex.h"
+
+using namespace std;
+using namespace FIX;
+
+// A tradable symbol as described by its NoRelatedSym entry of the SecurityList
+struct Instrument
+{
+	// Dense number of the instrument, 0 to InstrumentRegistry::size() - 1
+	int id;
+	string symbol;
+	// FXCMSymID (9000)
+	string fxcm_sym_id;
+	// FXCMSymPrecision (9001): decimals of the instrument's prices; 5 if not given
+	int digits;
+	// FXCMSymPointSize (9002)
+	double point_size;
+	// FXCMMinQuantity (9095) and FXCMMaxQuantity (9094); 0 if not given
+	double min_quantity;
+	double max_quantity;
+};
+
+// The instruments of the SecurityList embedded in TradingSessionStatus, numbered
+// densely in the order they first appear. An instrument keeps its ID when the
+// list is sent again, so IDs can index flat arrays such as the QuoteCache slots,
+// and code that has resolved a symbol once works in IDs from then on.
+//
+// Symbols resolve to IDs through a perfect hash that is rebuilt from scratch on
+// each update: a lookup hashes the symbol twice, reads one slot and compares one
+// string, with no probing. Updates copy the tables and publish the copy, so
+// lookups from other threads take no lock; the tables they replace are kept
+// until the registry is destroyed, which keeps every Instrument pointer valid.
+class InstrumentRegistry
+{
+public:
+	InstrumentRegistry();
+	~InstrumentRegistry();
+
+	// Adds or refreshes the instruments of each NoRelatedSym group of a
+	// TradingSessionStatus or SecurityList. Returns the number of instruments
+	size_t update(const FieldMap& security_list);
+
+	// ID of a symbol, or -1 if it is not in the SecurityList
+	int id(const string& symbol) const;
+	// NULL if the symbol or ID is unknown
+	const Instrument* find(const string& symbol) const;
+	const Instrument* get(int id) const;
+	size_t size() const;
+
+private:
+	InstrumentRegistry(const InstrumentRegistry&);
+	InstrumentRegistry& operator=(const InstrumentRegistry&);
+
+	static const int DEFAULT_DIGITS = 5;
+
+	enum FXCM_FIX_FIELDS
+	{
+		FXCM_SYM_ID         = 9000,
+		FXCM_SYM_PRECISION  = 9001,
+		FXCM_SYM_POINT_SIZE = 9002,
+		FXCM_MAX_QUANTITY   = 9094,
+		FXCM_MIN_QUANTITY   = 9095
+	};
+
+	// Instruments by ID and the perfect hash over their symbols. A symbol's
+	// bucket selects the seed that sends it to its own slot
+	struct Table
+	{
+		vector<Instrument> instruments;
+		vector<unsigned int> seeds;
+		vector<int> slots;
+		unsigned int bucket_mask;
+		unsigned int slot_mask;
+	};
+
+	static unsigned int hash(const string& symbol, unsigned int seed);
+	static void buildHash(Table& table);
+	static int lookup(const Table& table, const string& symbol);
+
+	Mutex mutex;
+	atomic<const Table*> table;
+	// Earlier tables; a reader may still be using one
+	vector<const Table*> retired;
+};
+
+#endif // INSTRUMENTREGISTRY_H
@@ -28,17 +28,23 @@ int main()
 		case 1: // Get positions 
 			app.GetPositions();
 			break;
-		case 2: // Subscribe to market data
-			app.SubscribeMarketData("EUR/USD");
-			app.SubscribeMarketData("EUR/JPY");
-			app.SubscribeMarketData("EUR/GBP");
+		case 2:{ // Subscribe to market data; one MarketDataRequest for all three
+			vector<string> symbols;
+			symbols.push_back("EUR/USD");
+			symbols.push_back("EUR/JPY");
+			symbols.push_back("EUR/GBP");
+			app.SubscribeMarketData(symbols);
 			break;
+		}
 		case 3: // Unsubscribe to market data
 			app.UnsubscribeMarketData();
 			break;
 		case 4: // Send market order
 			app.MarketOrder();
 			break;
+		case 5: // Subscribe to market data for every symbol in the SecurityList
+			app.SubscribeAllMarketData();
+			break;
 		}
 		if(exit)
 			break;
@@ -0,0 +1,192 @@
+#include "message_dispatcher.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "quickfix\Session.h"
+
+namespace
+{
+// Empty polls the consumer spins through before it starts sleeping
+const int IDLE_SPINS = 1000;
+const chrono::microseconds IDLE_SLEEP(100);
+}
+
+MessageDispatcher::MessageDispatcher(MessageCracker& cracker, size_t queue_size, FullPolicy full_policy)
+	: cracker(cracker)
+	, queue_size(queue_size)
+	, full_policy(full_policy)
+	, running(false)
+	, dropped(0)
+	, conflated(0)
+	, thread(0)
+{
+}
+
+MessageDispatcher::~MessageDispatcher()
+{
+	stop();
+	for(size_t i = 0; i < channel_list.size(); i++)
+		delete channel_list[i];
+}
+
+MessageDispatcher::FullPolicy MessageDispatcher::policy(const string& setting)
+{
+	if(setting == "Block")
+		return BLOCK;
+	if(setting == "Drop")
+		return DROP;
+	throw ConfigError("AppQueueFull must be Block or Drop, not " + setting);
+}
+
+void MessageDispatcher::addSession(const SessionID& session_ID)
+{
+	if(channels.count(session_ID))
+		return;
+	Channel* channel = new Channel(session_ID, queue_size);
+	channels[session_ID] = channel;
+	channel_list.push_back(channel);
+}
+
+void MessageDispatcher::start()
+{
+	if(running.exchange(true))
+		return;
+	if(!thread_spawn(&startThread, this, thread)){
+		running = false;
+		throw RuntimeError("Could not start the message dispatcher thread");
+	}
+}
+
+void MessageDispatcher::stop()
+{
+	if(!running.exchange(false))
+		return;
+	thread_join(thread);
+	thread = 0;
+}
+
+bool MessageDispatcher::post(const string& wire, const SessionID& session_ID)
+{
+	Channels::const_iterator i = channels.find(session_ID);
+	if(i == channels.end())
+		return false;
+	SpscQueue<string>& queue = i->second->queue;
+	// After stop nothing would handle it
+	if(!running.load(memory_order_relaxed)){
+		dropped.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+
+	string* slot = queue.beginPush();
+	while(!slot){
+		if(full_policy == DROP || !running.load(memory_order_relaxed)){
+			dropped.fetch_add(1, memory_order_relaxed);
+			return false;
+		}
+		this_thread::yield();
+		slot = queue.beginPush();
+	}
+	// The slot keeps its capacity, so this only copies
+	slot->assign(wire);
+	queue.commitPush();
+	return true;
+}
+
+bool MessageDispatcher::postLatest(const string& key, const string& wire, const SessionID& session_ID)
+{
+	Channels::const_iterator i = channels.find(session_ID);
+	if(i == channels.end())
+		return false;
+	if(!running.load(memory_order_relaxed)){
+		dropped.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+	Channel& channel = *i->second;
+	Locker locker(channel.latest_mutex);
+	Latest& latest = channel.latest[key];
+	if(latest.pending)
+		conflated.fetch_add(1, memory_order_relaxed);
+	latest.wire.assign(wire);
+	latest.pending = true;
+	channel.latest_pending.store(true, memory_order_release);
+	return true;
+}
+
+THREAD_PROC MessageDispatcher::startThread(void* p)
+{
+	static_cast<MessageDispatcher*>(p)->run();
+	return 0;
+}
+
+void MessageDispatcher::run()
+{
+	int idle = 0;
+	while(running.load(memory_order_relaxed)){
+		bool busy = false;
+		for(size_t i = 0; i < channel_list.size(); i++){
+			busy |= dispatch(*channel_list[i]);
+			busy |= dispatchLatest(*channel_list[i]);
+		}
+		if(busy)
+			idle = 0;
+		else if(++idle > IDLE_SPINS)
+			this_thread::sleep_for(IDLE_SLEEP);
+	}
+	// Whatever was posted before stop
+	for(size_t i = 0; i < channel_list.size(); i++){
+		while(dispatch(*channel_list[i]))
+			;
+		dispatchLatest(*channel_list[i]);
+	}
+}
+
+bool MessageDispatcher::dispatch(Channel& channel)
+{
+	string* raw = channel.queue.front();
+	if(!raw)
+		return false;
+	handle(channel, *raw);
+	channel.queue.pop();
+	return true;
+}
+
+bool MessageDispatcher::dispatchLatest(Channel& channel)
+{
+	if(!channel.latest_pending.load(memory_order_acquire))
+		return false;
+	size_t count = 0;
+	{
+		Locker locker(channel.latest_mutex);
+		for(LatestMessages::iterator i = channel.latest.begin(); i != channel.latest.end(); ++i){
+			if(!i->second.pending)
+				continue;
+			if(count == channel.taken.size())
+				channel.taken.push_back(string());
+			channel.taken[count++].swap(i->second.wire);
+			i->second.pending = false;
+		}
+		channel.latest_pending.store(false, memory_order_relaxed);
+	}
+	// Handled without the lock, so the socket thread can replace them meanwhile
+	for(size_t i = 0; i < count; i++)
+		handle(channel, channel.taken[i]);
+	return count > 0;
+}
+
+void MessageDispatcher::handle(Channel& channel, const string& raw)
+{
+	if(!channel.dictionary){
+		Session* session = Session::lookupSession(channel.session_ID);
+		if(session)
+			channel.dictionary = &session->getDataDictionaryProvider().getSessionDataDictionary(channel.session_ID.getBeginString());
+	}
+	try{
+		// Already validated by the session; the dictionary is needed for the groups
+		message.setString(raw, false, channel.dictionary, channel.dictionary);
+		cracker.crack(message, channel.session_ID);
+	}catch(UnsupportedMessageType&){
+		// fromApp has returned already, so the session cannot reject it any more
+	}catch(exception& e){
+		cout << "Dispatch failed for " << channel.session_ID << ": " << e.what() << endl;
+	}
+}
@@ -0,0 +1,124 @@
+#ifndef MESSAGEDISPATCHER_H
+#define MESSAGEDISPATCHER_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include "quickfix\DataDictionary.h"
+#include "quickfix\Message.h"
+#include "quickfix\MessageCracker.h"
+#include "quickfix\Mutex.h"
+#include "quickfix\SessionID.h"
+#include "quickfix\Utility.h"
+#include "spsc_queue.h"
+
+using namespace std;
+using namespace FIX;
+
+const char APP_QUEUE[] = "AppQueue";
+const char APP_QUEUE_SIZE[] = "AppQueueSize";
+const char APP_QUEUE_FULL[] = "AppQueueFull";
+
+// Moves application message handling off the socket threads. fromApp posts the
+// wire bytes of each message, as FastSocketConnection received them, to the
+// SpscQueue of its session (a session is always read by the same socket thread,
+// so each queue has one producer) and a consumer thread of its own parses them
+// and cracks the message. A slow handler then delays only the consumer, not the
+// socket reads, heartbeats and resends of the session.
+//
+// The socket thread only copies the bytes into a slot whose buffer is reused, so
+// posting allocates nothing once the queues have warmed up.
+//
+// When a queue is full, BLOCK makes the socket thread wait for room (back
+// pressure; nothing is lost but reads stall) and DROP discards the message and
+// counts it.
+//
+// Messages of which only the newest matters, such as the snapshots of a symbol,
+// are conflated instead of queued: postLatest keeps one message per key and
+// session, replacing one the consumer has not taken yet. A burst of quotes then
+// costs one handler call per symbol and never takes queue room from the
+// ExecutionReports. Conflated messages are handled out of order with the queued
+// ones, and the table of keys takes a short lock rather than a free slot.
+class MessageDispatcher
+{
+public:
+	enum FullPolicy { BLOCK, DROP };
+
+	MessageDispatcher(MessageCracker& cracker, size_t queue_size, FullPolicy full_policy);
+	~MessageDispatcher();
+
+	// Creates the queue of a session. All sessions must be added before start,
+	// from Application::onCreate for example
+	void addSession(const SessionID& session_ID);
+
+	void start();
+	// Handles what is still queued, then joins the consumer thread
+	void stop();
+
+	// Called on the session's socket thread with the raw bytes of a message. Returns
+	// false if the message was dropped or the session is unknown. Messages posted
+	// before start or after stop are dropped and counted
+	bool post(const string& wire, const SessionID& session_ID);
+	// Like post, but replaces a message with the same key that has not been handled
+	// yet. Never blocks or drops for lack of room
+	bool postLatest(const string& key, const string& wire, const SessionID& session_ID);
+
+	unsigned long long getDropped() const { return dropped.load(memory_order_relaxed); }
+	// Messages replaced by a newer one of the same key before they were handled
+	unsigned long long getConflated() const { return conflated.load(memory_order_relaxed); }
+
+	// FullPolicy for an AppQueueFull value; throws ConfigError unless Block or Drop
+	static FullPolicy policy(const string& setting);
+
+private:
+	struct Latest
+	{
+		Latest() : pending(false) {}
+
+		string wire;
+		bool pending;
+	};
+	typedef map<string, Latest> LatestMessages;
+
+	struct Channel
+	{
+		Channel(const SessionID& session_ID, size_t queue_size)
+			: session_ID(session_ID), queue(queue_size), dictionary(NULL), latest_pending(false) {}
+
+		SessionID session_ID;
+		SpscQueue<string> queue;
+		// Looked up by the consumer on first use
+		const DataDictionary* dictionary;
+
+		// Conflated messages by key. The consumer swaps pending ones out into taken,
+		// so the buffers go back and forth without being reallocated
+		Mutex latest_mutex;
+		LatestMessages latest;
+		atomic<bool> latest_pending;
+		vector<string> taken;
+	};
+	typedef map<SessionID, Channel*> Channels;
+
+	static THREAD_PROC startThread(void* p);
+	void run();
+	// Cracks the oldest message of a channel; false if it was empty
+	bool dispatch(Channel& channel);
+	// Cracks the pending conflated messages of a channel; false if there were none
+	bool dispatchLatest(Channel& channel);
+	void handle(Channel& channel, const string& raw);
+
+	MessageCracker& cracker;
+	size_t queue_size;
+	FullPolicy full_policy;
+	Channels channels;
+	vector<Channel*> channel_list;
+	atomic<bool> running;
+	atomic<unsigned long long> dropped;
+	atomic<unsigned long long> conflated;
+	thread_id thread;
+	// Parse target reused by the consumer
+	Message message;
+};
+
+#endif // MESSAGEDISPATCHER_H
@@ -0,0 +1,39 @@
+#ifndef MESSAGETEMPLATE_H
+#define MESSAGETEMPLATE_H
+
+#include "quickfix\Message.h"
+#include "quickfix\Session.h"
+#include "quickfix\SessionID.h"
+#include "outbound_throttle.h"
+
+using namespace FIX;
+
+// A message that is built once and sent many times. The constant fields and groups
+// are set when the template is filled in; each send only overwrites the variable
+// fields, in place, and hands the same object to Session::sendToTarget. The session
+// in turn overwrites MsgSeqNum, SendingTime, BodyLength and CheckSum in the same
+// header. No field or group object is constructed again after the first send.
+// Sent through an OutboundThrottle, a message that has to wait is queued as a
+// copy, so the template can be filled in again straight away.
+//
+// A template is not thread safe; use each one from a single thread.
+template <typename MessageType>
+class MessageTemplate
+{
+public:
+	// The message, for filling in the constant part
+	MessageType& message() { return msg; }
+
+	// Overwrites a variable field of the body
+	void set(const FieldBase& field) { msg.setField(field); }
+	// Instance num (1-based) of a group of the body, for overwriting fields inside it
+	FieldMap& group(int num, int field) { return msg.getGroupRef(num, field); }
+
+	bool send(const SessionID& session_ID) { return Session::sendToTarget(msg, session_ID); }
+	bool send(OutboundThrottle& throttle, const SessionID& session_ID) { return throttle.send(msg, session_ID); }
+
+private:
+	MessageType msg;
+};
+
+#endif // MESSAGETEMPLATE_H
\ No newline at end of file
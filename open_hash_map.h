@@ -0,0 +1,156 @@
+#ifndef OPENHASHMAP_H
+#define OPENHASHMAP_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A map from string keys to values in one flat array, probed linearly from the
+// key's hash. A lookup usually touches a single slot, and the hash kept in each
+// slot means most mismatches are rejected without comparing strings. Erased
+// slots become tombstones that later inserts reuse; the array doubles when live
+// and erased slots fill three quarters of it, or is rebuilt at the same size if
+// it is mostly tombstones.
+//
+// Pointers to values stay valid until the next insert. Not thread safe.
+template<typename Value>
+class OpenHashMap
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit OpenHashMap(size_t capacity = 16)
+		: count(0), erased(0)
+	{
+		size_t size = 8;
+		while(size < capacity)
+			size *= 2;
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	Value* find(const string& key)
+	{
+		size_t i = locate(key, hashOf(key));
+		return slots[i].state == FULL ? &slots[i].value : NULL;
+	}
+	const Value* find(const string& key) const
+	{
+		size_t i = locate(key, hashOf(key));
+		return slots[i].state == FULL ? &slots[i].value : NULL;
+	}
+
+	// Adds key, or overwrites its value if it is already there
+	Value& insert(const string& key, const Value& value)
+	{
+		if((count + erased + 1) * 4 > slots.size() * 3)
+			rehash(count * 2 >= slots.size() ? slots.size() * 2 : slots.size());
+		size_t hash = hashOf(key);
+		size_t i = locate(key, hash);
+		if(slots[i].state != FULL){
+			// The key is absent, so an earlier tombstone on its probe path can take it
+			size_t first = hash & mask;
+			while(slots[first].state == FULL)
+				first = (first + 1) & mask;
+			i = first;
+			if(slots[i].state == ERASED)
+				erased--;
+			slots[i].state = FULL;
+			slots[i].hash = hash;
+			slots[i].key = key;
+			count++;
+		}
+		slots[i].value = value;
+		return slots[i].value;
+	}
+
+	bool erase(const string& key)
+	{
+		size_t i = locate(key, hashOf(key));
+		if(slots[i].state != FULL)
+			return false;
+		slots[i].state = ERASED;
+		slots[i].value = Value();
+		count--;
+		erased++;
+		return true;
+	}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	// Calls f(key, value) for each entry, in no particular order
+	template<typename Function>
+	void forEach(Function f) const
+	{
+		for(size_t i = 0; i < slots.size(); i++){
+			if(slots[i].state == FULL)
+				f(slots[i].key, slots[i].value);
+		}
+	}
+
+private:
+	enum State { EMPTY, FULL, ERASED };
+
+	struct Slot
+	{
+		Slot() : hash(0), state(EMPTY), value() {}
+		size_t hash;
+		char state;
+		string key;
+		Value value;
+	};
+
+	// FNV-1a, finished with a multiply so the low bits used by mask mix all of it
+	static size_t hashOf(const string& key)
+	{
+		unsigned long long h = 14695981039346656037ULL;
+		for(size_t i = 0; i < key.size(); i++){
+			h ^= (unsigned char)key[i];
+			h *= 1099511628211ULL;
+		}
+		h ^= h >> 29;
+		h *= 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 32;
+		return (size_t)h;
+	}
+
+	// The slot holding key, or the empty slot that ends its probe path
+	size_t locate(const string& key, size_t hash) const
+	{
+		size_t i = hash & mask;
+		while(slots[i].state != EMPTY){
+			if(slots[i].state == FULL && slots[i].hash == hash && slots[i].key == key)
+				return i;
+			i = (i + 1) & mask;
+		}
+		return i;
+	}
+
+	void rehash(size_t capacity)
+	{
+		vector<Slot> old(capacity);
+		old.swap(slots);
+		mask = capacity - 1;
+		erased = 0;
+		for(size_t i = 0; i < old.size(); i++){
+			if(old[i].state != FULL)
+				continue;
+			size_t j = old[i].hash & mask;
+			while(slots[j].state != EMPTY)
+				j = (j + 1) & mask;
+			slots[j].state = FULL;
+			slots[j].hash = old[i].hash;
+			slots[j].key.swap(old[i].key);
+			slots[j].value = old[i].value;
+		}
+	}
+
+	vector<Slot> slots;
+	size_t mask;
+	size_t count;
+	size_t erased;
+};
+
+#endif // OPENHASHMAP_H
@@ -0,0 +1,223 @@
+#include "order_book.h"
+#include <algorithm>
+#include "fast_convertors.h"
+
+namespace
+{
+inline void readQuantity(const Message& report, int field, double& value)
+{
+	if(report.isSetField(field))
+		value = FastDoubleConvertor::convert(report.getField(field));
+}
+}
+
+OrderBook::OrderBook(const InstrumentRegistry& instruments)
+	: instruments(instruments)
+	, open_count(0)
+{
+}
+
+bool OrderBook::addOrder(const string& cl_ord_id, const string& account, const string& symbol, char side, double quantity)
+{
+	Locker locker(mutex);
+	if(by_cl_ord_id.find(cl_ord_id))
+		return false;
+	int record = allocate();
+	Order& order = records[record];
+	order.cl_ord_id = cl_ord_id;
+	order.account = account;
+	order.symbol = symbol;
+	order.instrument_id = instruments.id(symbol);
+	order.side = side;
+	order.ord_status = OrdStatus_PENDING_NEW;
+	order.order_qty = quantity;
+	order.leaves_qty = quantity;
+	by_cl_ord_id.insert(cl_ord_id, record);
+	updateTotals(order, 0, 0);
+	return true;
+}
+
+void OrderBook::apply(const Message& report)
+{
+	// Without a status there is nothing to apply
+	if(!report.isSetField(FIELD::OrdStatus) || report.getField(FIELD::OrdStatus).empty())
+		return;
+	string cl_ord_id;
+	string order_id;
+	if(report.isSetField(FIELD::ClOrdID))
+		cl_ord_id = report.getField(FIELD::ClOrdID);
+	if(report.isSetField(FIELD::OrderID))
+		order_id = report.getField(FIELD::OrderID);
+	char status = report.getField(FIELD::OrdStatus)[0];
+
+	Locker locker(mutex);
+	const int* found = cl_ord_id.empty() ? NULL : by_cl_ord_id.find(cl_ord_id);
+	if(!found && !order_id.empty())
+		found = by_order_id.find(order_id);
+	int record;
+	if(found){
+		record = *found;
+	}else{
+		if(isDone(status))
+			return;
+		record = allocate();
+		records[record].cl_ord_id = cl_ord_id;
+		if(!cl_ord_id.empty())
+			by_cl_ord_id.insert(cl_ord_id, record);
+	}
+
+	Order& order = records[record];
+	double old_leaves = order.leaves_qty;
+	double old_cum = order.cum_qty;
+	// Known once the server has accepted the order
+	if(!order_id.empty() && order_id != "NONE" && order_id != order.order_id){
+		if(!order.order_id.empty())
+			by_order_id.erase(order.order_id);
+		order.order_id = order_id;
+		by_order_id.insert(order_id, record);
+	}
+	// Account and symbol never change, and the totals rely on that
+	if(order.account.empty() && report.isSetField(FIELD::Account))
+		order.account = report.getField(FIELD::Account);
+	if(order.symbol.empty() && report.isSetField(FIELD::Symbol)){
+		order.symbol = report.getField(FIELD::Symbol);
+		order.instrument_id = instruments.id(order.symbol);
+	}
+	if(report.isSetField(FIELD::Side))
+		order.side = report.getField(FIELD::Side)[0];
+	readQuantity(report, FIELD::OrderQty, order.order_qty);
+	readQuantity(report, FIELD::CumQty, order.cum_qty);
+	readQuantity(report, FIELD::LeavesQty, order.leaves_qty);
+	readQuantity(report, FIELD::AvgPx, order.avg_px);
+	order.ord_status = status;
+	if(isDone(status))
+		order.leaves_qty = 0;
+	updateTotals(order, old_leaves, old_cum);
+
+	if(isDone(status)){
+		for(size_t i = 0; i < listeners.size(); i++)
+			listeners[i]->onOrderDone(order);
+		release(record);
+	}
+}
+
+bool OrderBook::find(const string& cl_ord_id, Order& order) const
+{
+	Locker locker(mutex);
+	const int* record = by_cl_ord_id.find(cl_ord_id);
+	if(!record)
+		return false;
+	order = records[*record];
+	return true;
+}
+
+bool OrderBook::findByOrderID(const string& order_id, Order& order) const
+{
+	Locker locker(mutex);
+	const int* record = by_order_id.find(order_id);
+	if(!record)
+		return false;
+	order = records[*record];
+	return true;
+}
+
+vector<Order> OrderBook::getOpenOrders() const
+{
+	Locker locker(mutex);
+	vector<Order> orders;
+	orders.reserve(open_count);
+	for(size_t i = 0; i < records.size(); i++){
+		if(in_use[i])
+			orders.push_back(records[i]);
+	}
+	return orders;
+}
+
+size_t OrderBook::size() const
+{
+	Locker locker(mutex);
+	return open_count;
+}
+
+OrderTotals OrderBook::getTotals(const string& account, int instrument_id) const
+{
+	Locker locker(mutex);
+	const AccountTotals* account_totals = totals.find(account);
+	if(!account_totals || instrument_id < 0 || instrument_id >= (int)account_totals->size())
+		return OrderTotals();
+	return (*account_totals)[instrument_id];
+}
+
+void OrderBook::addListener(OrderListener* listener)
+{
+	Locker locker(mutex);
+	listeners.push_back(listener);
+}
+
+void OrderBook::removeListener(OrderListener* listener)
+{
+	Locker locker(mutex);
+	listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+bool OrderBook::isDone(char ord_status)
+{
+	return ord_status == '2' || ord_status == '4' || ord_status == '8' || ord_status == 'C';
+}
+
+int OrderBook::allocate()
+{
+	int record;
+	if(free_records.empty()){
+		record = (int)records.size();
+		records.push_back(Order());
+		in_use.push_back(true);
+	}else{
+		record = free_records.back();
+		free_records.pop_back();
+		in_use[record] = true;
+	}
+	// Strings are cleared rather than replaced, so they keep their buffers
+	Order& order = records[record];
+	order.cl_ord_id.clear();
+	order.order_id.clear();
+	order.account.clear();
+	order.symbol.clear();
+	order.instrument_id = -1;
+	order.side = 0;
+	order.ord_status = 0;
+	order.order_qty = 0;
+	order.cum_qty = 0;
+	order.leaves_qty = 0;
+	order.avg_px = 0;
+	open_count++;
+	return record;
+}
+
+void OrderBook::release(int record)
+{
+	Order& order = records[record];
+	if(!order.cl_ord_id.empty())
+		by_cl_ord_id.erase(order.cl_ord_id);
+	if(!order.order_id.empty())
+		by_order_id.erase(order.order_id);
+	in_use[record] = false;
+	free_records.push_back(record);
+	open_count--;
+}
+
+void OrderBook::updateTotals(const Order& order, double old_leaves, double old_cum)
+{
+	if(order.account.empty() || order.instrument_id < 0)
+		return;
+	AccountTotals* account_totals = totals.find(order.account);
+	if(!account_totals)
+		account_totals = &totals.insert(order.account, AccountTotals());
+	if(order.instrument_id >= (int)account_totals->size()){
+		size_t size = instruments.size() > (size_t)order.instrument_id ? instruments.size() : order.instrument_id + 1;
+		account_totals->resize(size, OrderTotals());
+	}
+	OrderTotals& instrument_totals = (*account_totals)[order.instrument_id];
+	instrument_totals.working_qty += order.leaves_qty - old_leaves;
+	instrument_totals.filled_qty += order.cum_qty - old_cum;
+}
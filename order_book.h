@@ -0,0 +1,114 @@
+#ifndef ORDERBOOK_H
+#define ORDERBOOK_H
+
+#include <string>
+#include <vector>
+#include "quickfix\Message.h"
+#include "quickfix\Mutex.h"
+#include "instrument_registry.h"
+#include "open_hash_map.h"
+
+using namespace std;
+using namespace FIX;
+
+// One of our orders as the latest ExecutionReport describes it
+struct Order
+{
+	string cl_ord_id;
+	string order_id;
+	string account;
+	string symbol;
+	// InstrumentRegistry ID of symbol; -1 if it is not in the SecurityList
+	int instrument_id;
+	char side;
+	// OrdStatus (39); '0' new and 'A' pending new are working, and Filled (2),
+	// Canceled (4), Rejected (8) and Expired (C) are final
+	char ord_status;
+	double order_qty;
+	double cum_qty;
+	double leaves_qty;
+	double avg_px;
+};
+
+// Quantities of an account in one instrument
+struct OrderTotals
+{
+	// Sum of LeavesQty of the open orders
+	double working_qty;
+	// Sum of CumQty of all orders
+	double filled_qty;
+};
+
+// Told when an order reaches a final OrdStatus, just before the book forgets it
+class OrderListener
+{
+public:
+	virtual ~OrderListener() {}
+	virtual void onOrderDone(const Order& order) = 0;
+};
+
+// Our open orders, kept up to date from the ExecutionReports as they arrive, so
+// that what is open right now and how much is working or filled per account and
+// instrument can be asked at any time instead of replayed from the logs.
+//
+// Orders are found by ClOrdID or OrderID through OpenHashMaps and live in a pool
+// of records that are reused once an order is done, so a steady flow of orders
+// allocates nothing after warming up. Each report is applied as a difference:
+// only its change of LeavesQty and CumQty touches the totals. An order that is
+// done is reported to the listeners and dropped.
+//
+// All members lock one mutex; apply runs on the thread that cracks the reports.
+class OrderBook
+{
+public:
+	explicit OrderBook(const InstrumentRegistry& instruments);
+
+	// Records an order we are about to send, so that it counts as working before
+	// its first ExecutionReport. Returns false, recording nothing, if the ClOrdID is
+	// already in the book; the order must then not be sent, or its reports would be
+	// applied to the other order
+	bool addOrder(const string& cl_ord_id, const string& account, const string& symbol, char side, double quantity);
+	// Applies an ExecutionReport. Reports of orders we do not know are added as new
+	// orders unless they are already done; reports without an OrdStatus are skipped
+	void apply(const Message& report);
+
+	// Copies an open order; false if there is none
+	bool find(const string& cl_ord_id, Order& order) const;
+	bool findByOrderID(const string& order_id, Order& order) const;
+	vector<Order> getOpenOrders() const;
+	size_t size() const;
+	OrderTotals getTotals(const string& account, int instrument_id) const;
+
+	// Listeners are called with the mutex held and must not call back into the book
+	void addListener(OrderListener* listener);
+	void removeListener(OrderListener* listener);
+
+	static bool isDone(char ord_status);
+
+private:
+	OrderBook(const OrderBook&);
+	OrderBook& operator=(const OrderBook&);
+
+	// Totals of an account by instrument ID
+	typedef vector<OrderTotals> AccountTotals;
+
+	int allocate();
+	void release(int record);
+	// Adds the change from old_leaves and old_cum to an order's totals
+	void updateTotals(const Order& order, double old_leaves, double old_cum);
+
+	const InstrumentRegistry& instruments;
+	mutable Mutex mutex;
+	// Pool of order records; in_use tells the live ones from those on free_records
+	vector<Order> records;
+	vector<bool> in_use;
+	vector<int> free_records;
+	size_t open_count;
+	// Record numbers by ClOrdID and by OrderID
+	OpenHashMap<int> by_cl_ord_id;
+	OpenHashMap<int> by_order_id;
+	OpenHashMap<AccountTotals> totals;
+	vector<OrderListener*> listeners;
+};
+
+#endif // ORDERBOOK_H
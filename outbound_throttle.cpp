@@ -0,0 +1,197 @@
+#include "outbound_throttle.h"
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "quickfix\Session.h"
+#include "quickfix\Values.h"
+
+OutboundThrottle::OutboundThrottle(int interval_ms)
+	: interval(interval_ms > 0 ? interval_ms : DEFAULT_INTERVAL_MS)
+	, running(false)
+	, queued(0)
+	, discarded(0)
+	, thread(0)
+{
+}
+
+OutboundThrottle::~OutboundThrottle()
+{
+	stop();
+}
+
+void OutboundThrottle::addSession(const SessionID& session_ID, double rate, double burst)
+{
+	Locker locker(mutex);
+	Lane& lane = lanes[session_ID];
+	lane.rate = rate;
+	lane.burst = burst > 1 ? burst : 1;
+	lane.tokens = lane.burst;
+	lane.last_refill = chrono::steady_clock::now();
+}
+
+void OutboundThrottle::start()
+{
+	if(running.exchange(true))
+		return;
+	if(!thread_spawn(&startThread, this, thread)){
+		running = false;
+		throw RuntimeError("Could not start the outbound throttle thread");
+	}
+}
+
+void OutboundThrottle::stop()
+{
+	if(!running.exchange(false))
+		return;
+	thread_join(thread);
+	thread = 0;
+
+	Locker locker(mutex);
+	for(Lanes::iterator i = lanes.begin(); i != lanes.end(); ++i)
+		discard(i);
+}
+
+void OutboundThrottle::clear(const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	Lanes::iterator i = lanes.find(session_ID);
+	if(i != lanes.end())
+		discard(i);
+}
+
+bool OutboundThrottle::send(Message& message, const SessionID& session_ID)
+{
+	return send(message, session_ID, priority(message));
+}
+
+bool OutboundThrottle::send(Message& message, const SessionID& session_ID, Priority priority)
+{
+	{
+		Locker locker(mutex);
+		Lanes::iterator i = lanes.find(session_ID);
+		if(i != lanes.end() && i->second.rate > 0){
+			Lane& lane = i->second;
+			refill(lane, chrono::steady_clock::now());
+			if(lane.tokens < 1 || !isClear(lane, priority)){
+				// Nothing would ever send it
+				if(!running.load(memory_order_relaxed)){
+					discarded.fetch_add(1, memory_order_relaxed);
+					return false;
+				}
+				lane.queues[priority].push_back(message);
+				queued.fetch_add(1, memory_order_relaxed);
+				return true;
+			}
+			lane.tokens -= 1;
+		}
+	}
+	return Session::sendToTarget(message, session_ID);
+}
+
+size_t OutboundThrottle::depth(const SessionID& session_ID) const
+{
+	Locker locker(mutex);
+	Lanes::const_iterator i = lanes.find(session_ID);
+	if(i == lanes.end())
+		return 0;
+	size_t total = 0;
+	for(int p = 0; p < PRIORITIES; p++)
+		total += i->second.queues[p].size();
+	return total;
+}
+
+size_t OutboundThrottle::depth(const SessionID& session_ID, Priority priority) const
+{
+	Locker locker(mutex);
+	Lanes::const_iterator i = lanes.find(session_ID);
+	return i == lanes.end() ? 0 : i->second.queues[priority].size();
+}
+
+OutboundThrottle::Priority OutboundThrottle::priority(const Message& message)
+{
+	const string& msg_type = message.getHeader().getField(FIELD::MsgType);
+	if(msg_type == MsgType_OrderCancelRequest || msg_type == MsgType_OrderCancelReplaceRequest)
+		return CANCEL;
+	if(msg_type == MsgType_NewOrderSingle || msg_type == MsgType_NewOrderList)
+		return NEW_ORDER;
+	return REQUEST;
+}
+
+THREAD_PROC OutboundThrottle::startThread(void* p)
+{
+	static_cast<OutboundThrottle*>(p)->run();
+	return 0;
+}
+
+void OutboundThrottle::run()
+{
+	while(running.load(memory_order_relaxed)){
+		this_thread::sleep_for(interval);
+		drain();
+	}
+}
+
+void OutboundThrottle::drain()
+{
+	// Taken off the queues under the lock and sent after it is released
+	vector<pair<Message, SessionID> > ready;
+	{
+		Locker locker(mutex);
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		for(Lanes::iterator i = lanes.begin(); i != lanes.end(); ++i){
+			// Waits for the logon; a logout clears it
+			Session* session = Session::lookupSession(i->first);
+			if(!session || !session->isLoggedOn())
+				continue;
+			Lane& lane = i->second;
+			refill(lane, now);
+			for(int p = 0; p < PRIORITIES; p++){
+				deque<Message>& queue = lane.queues[p];
+				while(lane.tokens >= 1 && !queue.empty()){
+					ready.push_back(make_pair(queue.front(), i->first));
+					queue.pop_front();
+					lane.tokens -= 1;
+				}
+			}
+		}
+	}
+	for(size_t i = 0; i < ready.size(); i++){
+		try{
+			Session::sendToTarget(ready[i].first, ready[i].second);
+		}catch(SessionNotFound&){
+			cout << "Outbound queue: session " << ready[i].second << " not found" << endl;
+		}
+	}
+}
+
+void OutboundThrottle::refill(Lane& lane, chrono::steady_clock::time_point now)
+{
+	lane.tokens += chrono::duration<double>(now - lane.last_refill).count() * lane.rate;
+	if(lane.tokens > lane.burst)
+		lane.tokens = lane.burst;
+	lane.last_refill = now;
+}
+
+size_t OutboundThrottle::discard(Lanes::iterator lane)
+{
+	size_t left = 0;
+	for(int p = 0; p < PRIORITIES; p++){
+		left += lane->second.queues[p].size();
+		lane->second.queues[p].clear();
+	}
+	if(left){
+		discarded.fetch_add(left, memory_order_relaxed);
+		cout << "Outbound queue of " << lane->first << " discarded " << left << " messages" << endl;
+	}
+	return left;
+}
+
+bool OutboundThrottle::isClear(const Lane& lane, Priority priority)
+{
+	for(int p = 0; p <= priority; p++){
+		if(!lane.queues[p].empty())
+			return false;
+	}
+	return true;
+}
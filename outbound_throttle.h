@@ -0,0 +1,112 @@
+#ifndef OUTBOUNDTHROTTLE_H
+#define OUTBOUNDTHROTTLE_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include "quickfix\Message.h"
+#include "quickfix\Mutex.h"
+#include "quickfix\SessionID.h"
+#include "quickfix\Utility.h"
+
+using namespace std;
+using namespace FIX;
+
+// Per session: messages per second (0 sends at once) and how many may go at once
+const char THROTTLE_RATE[] = "ThrottleRate";
+const char THROTTLE_BURST[] = "ThrottleBurst";
+// Milliseconds between drains of the queues
+const char THROTTLE_INTERVAL[] = "ThrottleInterval";
+
+// Keeps the application messages we send under FXCM's rate limits. Each session
+// has a token bucket of ThrottleRate tokens a second, holding at most ThrottleBurst.
+// A message goes out at once while there are tokens and nothing of the same or a
+// higher priority waits; otherwise a copy of it is queued, and a thread of its own
+// drains the queues every ThrottleInterval milliseconds as tokens come back.
+//
+// Queued messages leave by priority and, within one, in the order they were
+// queued: cancels and replaces before new orders before position and other
+// requests, so a burst of requests never holds up getting out of an order. A
+// cancel can therefore overtake a queued order it refers to, which FXCM rejects.
+//
+// This sits in front of Session::sendToTarget rather than inside Session::send,
+// which belongs to the engine: messages sent straight to the session, and admin
+// messages, are not counted. Sessions are added before start, from
+// Application::onCreate for example; the others are not throttled. Messages are
+// sent without the lock held, so the session may call back into the application.
+//
+// Queued messages do not outlive the connection they were meant for: clear is
+// called on logout, and drain leaves the queues of sessions that are not logged
+// on alone. A message that would have to wait while the drain thread is not
+// running, before start or after stop, is discarded rather than queued for good.
+class OutboundThrottle
+{
+public:
+	enum Priority { CANCEL, NEW_ORDER, REQUEST, PRIORITIES };
+	enum { DEFAULT_INTERVAL_MS = 10 };
+
+	explicit OutboundThrottle(int interval_ms = DEFAULT_INTERVAL_MS);
+	~OutboundThrottle();
+
+	void addSession(const SessionID& session_ID, double rate, double burst);
+
+	void start();
+	// Joins the drain thread. Messages still queued are discarded, and counted
+	void stop();
+	// Discards and counts the messages queued for a session, e.g. when it logs out
+	void clear(const SessionID& session_ID);
+
+	// Sends the message or queues a copy of it. The priority is that of its MsgType
+	// unless given. Returns false if it was sent and the session refused it, or if
+	// it had to wait while the drain thread is not running and was discarded
+	bool send(Message& message, const SessionID& session_ID);
+	bool send(Message& message, const SessionID& session_ID, Priority priority);
+
+	// Messages waiting to be sent, in all or one priority
+	size_t depth(const SessionID& session_ID) const;
+	size_t depth(const SessionID& session_ID, Priority priority) const;
+	// Messages that had to wait, and those discarded by stop, clear or send, since
+	// construction
+	unsigned long long getQueued() const { return queued.load(memory_order_relaxed); }
+	unsigned long long getDiscarded() const { return discarded.load(memory_order_relaxed); }
+
+	// OrderCancelRequest and OrderCancelReplaceRequest are CANCEL, NewOrderSingle
+	// and NewOrderList NEW_ORDER, the rest REQUEST
+	static Priority priority(const Message& message);
+
+private:
+	OutboundThrottle(const OutboundThrottle&);
+	OutboundThrottle& operator=(const OutboundThrottle&);
+
+	struct Lane
+	{
+		double rate;
+		double burst;
+		double tokens;
+		chrono::steady_clock::time_point last_refill;
+		deque<Message> queues[PRIORITIES];
+	};
+	typedef map<SessionID, Lane> Lanes;
+
+	static THREAD_PROC startThread(void* p);
+	void run();
+	// Sends what the tokens of each session allow
+	void drain();
+	static void refill(Lane& lane, chrono::steady_clock::time_point now);
+	// True if nothing of priority or a higher one is queued
+	static bool isClear(const Lane& lane, Priority priority);
+	// Empties the queues of a lane; returns the number of messages discarded
+	size_t discard(Lanes::iterator lane);
+
+	mutable Mutex mutex;
+	Lanes lanes;
+	chrono::milliseconds interval;
+	atomic<bool> running;
+	atomic<unsigned long long> queued;
+	atomic<unsigned long long> discarded;
+	thread_id thread;
+};
+
+#endif // OUTBOUNDTHROTTLE_H
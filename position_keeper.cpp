@@ -0,0 +1,173 @@
+#include "position_keeper.h"
+#include <algorithm>
+#include "quickfix\fix44\PositionReport.h"
+#include "fast_convertors.h"
+
+PositionKeeper::PositionKeeper(const InstrumentRegistry& instruments)
+	: instruments(instruments)
+{
+}
+
+// FXCM reports each position (ticket) by FXCMPosID, with its open price in
+// SettlPrice and its size in the NoPositions group. A report with FXCMPosCloseTime
+// or no quantity left closes the position
+void PositionKeeper::apply(const Message& report)
+{
+	if(!report.isSetField(FXCM_POS_ID) || !report.isSetField(FIELD::Symbol))
+		return;
+	string position_id = report.getField(FXCM_POS_ID);
+	string account = report.getField(FIELD::Account);
+	int instrument_id = instruments.id(report.getField(FIELD::Symbol));
+	bool closed = report.isSetField(FXCM_POS_CLOSE_TIME);
+
+	double long_qty = 0;
+	double short_qty = 0;
+	if(report.isSetField(FIELD::NoPositions)){
+		int count = FastIntConvertor::convert(report.getField(FIELD::NoPositions));
+		FIX44::PositionReport::NoPositions group;
+		for(int i = 1; i <= count; i++){
+			report.getGroup(i, group);
+			if(group.isSetField(FIELD::LongQty))
+				long_qty += FastDoubleConvertor::convert(group.getField(FIELD::LongQty));
+			if(group.isSetField(FIELD::ShortQty))
+				short_qty += FastDoubleConvertor::convert(group.getField(FIELD::ShortQty));
+		}
+	}
+	double price = 0;
+	if(report.isSetField(FIELD::SettlPrice))
+		price = FastDoubleConvertor::convert(report.getField(FIELD::SettlPrice));
+
+	Locker locker(mutex);
+	const Ticket* old = tickets.find(position_id);
+	if(old){
+		Ticket previous = *old;
+		addTicket(previous, -1);
+		tickets.erase(position_id);
+	}
+	if(closed || (long_qty == 0 && short_qty == 0) || instrument_id < 0)
+		return;
+	Ticket ticket = { accountNumber(account), instrument_id, long_qty, short_qty, price };
+	tickets.insert(position_id, ticket);
+	addTicket(ticket, 1);
+}
+
+void PositionKeeper::onQuote(int instrument_id, const FixedPrice& bid, const FixedPrice& ask)
+{
+	Locker locker(mutex);
+	reserve(instrument_id);
+	Mark& prices = marks[instrument_id];
+	prices.bid = bid.toDouble();
+	prices.ask = ask.toDouble();
+	const vector<int>& accounts_holding = holders[instrument_id];
+	for(size_t i = 0; i < accounts_holding.size(); i++)
+		mark(accounts[accounts_holding[i]].positions[instrument_id], prices);
+}
+
+bool PositionKeeper::startSubscription(const string& account)
+{
+	Locker locker(mutex);
+	Account& state = accounts[accountNumber(account)];
+	if(state.subscribed)
+		return false;
+	state.subscribed = true;
+	return true;
+}
+
+void PositionKeeper::onLogout()
+{
+	Locker locker(mutex);
+	tickets = OpenHashMap<Ticket>();
+	for(size_t i = 0; i < accounts.size(); i++){
+		accounts[i].subscribed = false;
+		accounts[i].positions.clear();
+	}
+	for(size_t i = 0; i < holders.size(); i++)
+		holders[i].clear();
+}
+
+Position PositionKeeper::getPosition(const string& account, int instrument_id) const
+{
+	Locker locker(mutex);
+	const int* number = account_numbers.find(account);
+	if(!number || instrument_id < 0 || instrument_id >= (int)accounts[*number].positions.size())
+		return Position();
+	return accounts[*number].positions[instrument_id];
+}
+
+vector<Position> PositionKeeper::getPositions(const string& account) const
+{
+	Locker locker(mutex);
+	const int* number = account_numbers.find(account);
+	if(!number)
+		return vector<Position>();
+	return accounts[*number].positions;
+}
+
+double PositionKeeper::getUnrealizedPnL(const string& account, int instrument_id) const
+{
+	return getPosition(account, instrument_id).unrealized_pnl;
+}
+
+int PositionKeeper::accountNumber(const string& name)
+{
+	const int* number = account_numbers.find(name);
+	if(number)
+		return *number;
+	Account account;
+	account.name = name;
+	account.subscribed = false;
+	accounts.push_back(account);
+	account_numbers.insert(name, (int)accounts.size() - 1);
+	return (int)accounts.size() - 1;
+}
+
+void PositionKeeper::addTicket(const Ticket& ticket, int sign)
+{
+	reserve(ticket.instrument_id);
+	Account& account = accounts[ticket.account];
+	reserve(account, ticket.instrument_id);
+	Position& position = account.positions[ticket.instrument_id];
+	position.long_qty += sign * ticket.long_qty;
+	position.long_cost += sign * ticket.long_qty * ticket.price;
+	position.short_qty += sign * ticket.short_qty;
+	position.short_cost += sign * ticket.short_qty * ticket.price;
+	position.tickets += sign;
+
+	vector<int>& accounts_holding = holders[ticket.instrument_id];
+	if(position.tickets == 1 && sign > 0)
+		accounts_holding.push_back(ticket.account);
+	if(position.tickets == 0){
+		accounts_holding.erase(std::find(accounts_holding.begin(), accounts_holding.end(), ticket.account));
+		// Starts from exact zeros again rather than the rounding left by the sums
+		position = Position();
+	}else{
+		mark(position, marks[ticket.instrument_id]);
+	}
+}
+
+void PositionKeeper::mark(Position& position, const Mark& prices)
+{
+	if(prices.bid <= 0 || prices.ask <= 0){
+		position.unrealized_pnl = 0;
+		return;
+	}
+	position.unrealized_pnl = position.long_qty * prices.bid - position.long_cost
+		+ position.short_cost - position.short_qty * prices.ask;
+}
+
+void PositionKeeper::reserve(Account& account, int instrument_id)
+{
+	if(instrument_id < (int)account.positions.size())
+		return;
+	size_t size = instruments.size() > (size_t)instrument_id ? instruments.size() : instrument_id + 1;
+	account.positions.resize(size, Position());
+}
+
+void PositionKeeper::reserve(int instrument_id)
+{
+	if(instrument_id < (int)holders.size())
+		return;
+	size_t size = instruments.size() > (size_t)instrument_id ? instruments.size() : instrument_id + 1;
+	holders.resize(size);
+	marks.resize(size, Mark());
+}
@@ -0,0 +1,116 @@
+#ifndef POSITIONKEEPER_H
+#define POSITIONKEEPER_H
+
+#include <string>
+#include <vector>
+#include "quickfix\Message.h"
+#include "quickfix\Mutex.h"
+#include "fixed_price.h"
+#include "instrument_registry.h"
+#include "open_hash_map.h"
+
+using namespace std;
+using namespace FIX;
+
+// The open positions of an account in one instrument, summed over its FXCM
+// positions (tickets). Costs are quantity times open price, so the average open
+// price of the long side is long_cost / long_qty
+struct Position
+{
+	double long_qty;
+	double long_cost;
+	double short_qty;
+	double short_cost;
+	// Marked to the latest bid (longs) and ask (shorts), in the instrument's
+	// quote currency; 0 until the instrument has been quoted
+	double unrealized_pnl;
+	int tickets;
+
+	double netQty() const { return long_qty - short_qty; }
+};
+
+// Open positions of each account, kept from PositionReports (a snapshot followed
+// by updates when subscribed with SubscriptionRequestType 1) and marked to market
+// on every quote. Each account has a flat array of Positions indexed by
+// instrument ID, and each instrument a list of the accounts holding it, so a
+// tick recomputes the P&L of exactly the positions in the instrument that
+// ticked, each in constant time from the summed quantities and costs.
+//
+// All members lock one mutex.
+class PositionKeeper
+{
+public:
+	explicit PositionKeeper(const InstrumentRegistry& instruments);
+
+	// Opens, changes or closes the FXCM position of a PositionReport
+	void apply(const Message& report);
+	// Marks the positions in an instrument to a new quote
+	void onQuote(int instrument_id, const FixedPrice& bid, const FixedPrice& ask);
+
+	// True the first time it is called for an account after construction or
+	// onLogout; the caller then subscribes to the account's positions
+	bool startSubscription(const string& account);
+	// The server drops position subscriptions with the session, and the next
+	// snapshot describes all positions again, so everything is forgotten
+	void onLogout();
+
+	Position getPosition(const string& account, int instrument_id) const;
+	// Positions of an account by instrument ID
+	vector<Position> getPositions(const string& account) const;
+	// Sum of the unrealized P&L of an account's positions in an instrument's quote
+	// currency; callers converting to the account currency work per instrument
+	double getUnrealizedPnL(const string& account, int instrument_id) const;
+
+private:
+	PositionKeeper(const PositionKeeper&);
+	PositionKeeper& operator=(const PositionKeeper&);
+
+	enum FXCM_FIX_FIELDS
+	{
+		FXCM_POS_ID         = 9041,
+		FXCM_POS_CLOSE_TIME = 9044
+	};
+
+	// One FXCM position as last reported
+	struct Ticket
+	{
+		int account;
+		int instrument_id;
+		double long_qty;
+		double short_qty;
+		double price;
+	};
+
+	struct Account
+	{
+		string name;
+		bool subscribed;
+		vector<Position> positions;
+	};
+
+	// Latest prices of an instrument
+	struct Mark
+	{
+		double bid;
+		double ask;
+	};
+
+	int accountNumber(const string& name);
+	// Adds a ticket to its position, or with sign -1 takes it away
+	void addTicket(const Ticket& ticket, int sign);
+	void mark(Position& position, const Mark& prices);
+	// Sizes the per instrument arrays to cover instrument_id
+	void reserve(Account& account, int instrument_id);
+	void reserve(int instrument_id);
+
+	const InstrumentRegistry& instruments;
+	mutable Mutex mutex;
+	OpenHashMap<Ticket> tickets;
+	OpenHashMap<int> account_numbers;
+	vector<Account> accounts;
+	// By instrument ID: the accounts with open tickets in it, and its prices
+	vector<vector<int> > holders;
+	vector<Mark> marks;
+};
+
+#endif // POSITIONKEEPER_H
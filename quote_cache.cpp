@@ -0,0 +1,103 @@
+#include "quote_cache.h"
+#include <new>
+
+namespace
+{
+const long long NANOS_PER_SECOND = 1000000000LL;
+
+inline long long toNanos(const WallTime& time)
+{
+	return time.seconds * NANOS_PER_SECOND + time.nanos;
+}
+
+inline WallTime fromNanos(long long nanos)
+{
+	WallTime time = { nanos / NANOS_PER_SECOND, (int)(nanos % NANOS_PER_SECOND) };
+	return time;
+}
+}
+
+QuoteCache::QuoteCache(size_t capacity)
+	: slot_count(capacity)
+	, memory(new char[(capacity + 1) * CACHE_LINE])
+{
+	static_assert(sizeof(Slot) <= CACHE_LINE, "a quote slot must fit a cache line");
+	size_t misalignment = (size_t)memory % CACHE_LINE;
+	slots = memory + (misalignment ? CACHE_LINE - misalignment : 0);
+	for(size_t i = 0; i < slot_count; i++){
+		Slot* s = new (slots + i * CACHE_LINE) Slot;
+		s->sequence.store(0, memory_order_relaxed);
+		s->digits.store(0, memory_order_relaxed);
+		s->bid.store(0, memory_order_relaxed);
+		s->ask.store(0, memory_order_relaxed);
+		s->high.store(0, memory_order_relaxed);
+		s->low.store(0, memory_order_relaxed);
+		s->sending_time.store(0, memory_order_relaxed);
+		s->receive_time.store(0, memory_order_relaxed);
+	}
+}
+
+QuoteCache::~QuoteCache()
+{
+	for(size_t i = 0; i < slot_count; i++)
+		slot((int)i).~Slot();
+	delete[] memory;
+}
+
+void QuoteCache::update(int id, const Quote& quote)
+{
+	if(!hasSlot(id))
+		return;
+	Slot& s = slot(id);
+	unsigned int sequence = s.sequence.load(memory_order_relaxed);
+	s.sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	s.digits.store(quote.bid.getDigits(), memory_order_relaxed);
+	s.bid.store(quote.bid.getUnits(), memory_order_relaxed);
+	s.ask.store(quote.ask.getUnits(), memory_order_relaxed);
+	s.high.store(quote.high.getUnits(), memory_order_relaxed);
+	s.low.store(quote.low.getUnits(), memory_order_relaxed);
+	s.sending_time.store(toNanos(quote.sending_time), memory_order_relaxed);
+	s.receive_time.store(toNanos(quote.receive_time), memory_order_relaxed);
+	s.sequence.store(sequence + 2, memory_order_release);
+}
+
+bool QuoteCache::read(int id, Quote& quote) const
+{
+	if(!hasSlot(id))
+		return false;
+	const Slot& s = slot(id);
+	unsigned int before, after;
+	int digits;
+	long long bid, ask, high, low, sending_time, receive_time;
+	do{
+		before = s.sequence.load(memory_order_acquire);
+		while(before & 1)
+			before = s.sequence.load(memory_order_acquire);
+		digits = s.digits.load(memory_order_relaxed);
+		bid = s.bid.load(memory_order_relaxed);
+		ask = s.ask.load(memory_order_relaxed);
+		high = s.high.load(memory_order_relaxed);
+		low = s.low.load(memory_order_relaxed);
+		sending_time = s.sending_time.load(memory_order_relaxed);
+		receive_time = s.receive_time.load(memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		after = s.sequence.load(memory_order_relaxed);
+	}while(before != after);
+
+	quote.bid = FixedPrice(bid, digits);
+	quote.ask = FixedPrice(ask, digits);
+	quote.high = FixedPrice(high, digits);
+	quote.low = FixedPrice(low, digits);
+	quote.sending_time = fromNanos(sending_time);
+	quote.receive_time = fromNanos(receive_time);
+	quote.version = before / 2;
+	return quote.version > 0;
+}
+
+unsigned int QuoteCache::version(int id) const
+{
+	if(!hasSlot(id))
+		return 0;
+	return slot(id).sequence.load(memory_order_acquire) / 2;
+}
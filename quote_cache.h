@@ -0,0 +1,87 @@
+#ifndef QUOTECACHE_H
+#define QUOTECACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include "fixed_price.h"
+#include "utc_clock.h"
+
+using namespace std;
+using namespace FIX;
+
+const char QUOTE_CACHE_SIZE[] = "QuoteCacheSize";
+
+// The latest quote of an instrument as copied out of a QuoteCache
+struct Quote
+{
+	FixedPrice bid;
+	FixedPrice ask;
+	FixedPrice high;
+	FixedPrice low;
+	// SendingTime of the snapshot, and when we received it
+	WallTime sending_time;
+	WallTime receive_time;
+	// Number of updates so far; 0 if the symbol has not been quoted yet
+	unsigned int version;
+};
+
+// Latest bid, ask, high and low of each instrument, for threads that only want
+// the current price and not every snapshot. There is one slot per instrument ID
+// of the InstrumentRegistry, and each slot is a cache line of its own in an array
+// allocated once, so a snapshot overwrites its instrument's quote in place and a
+// burst of snapshots conflates to the last one.
+//
+// Each slot is a seqlock: the one thread updating an instrument makes its
+// sequence odd, writes the fields and makes it even again, and readers copy the
+// fields and retry if the sequence was odd or moved meanwhile. Readers take no
+// lock and never delay the writer; version tells whether anything changed since
+// the last read.
+class QuoteCache
+{
+public:
+	explicit QuoteCache(size_t capacity);
+	~QuoteCache();
+
+	// Number of slots; instruments with higher IDs are not cached
+	size_t capacity() const { return slot_count; }
+
+	// Overwrites the quote of an instrument. Only one thread may update a given
+	// instrument; quote.version is ignored. IDs without a slot are ignored
+	void update(int id, const Quote& quote);
+	// Copies the latest quote of an instrument; false if it has not been quoted yet
+	// or has no slot
+	bool read(int id, Quote& quote) const;
+	// Version of an instrument's quote without copying it; 0 if it has no slot
+	unsigned int version(int id) const;
+
+private:
+	QuoteCache(const QuoteCache&);
+	QuoteCache& operator=(const QuoteCache&);
+
+	enum { CACHE_LINE = 64 };
+
+	// Relaxed atomics rather than plain fields, so the copies a reader makes
+	// while the writer is busy are merely discarded rather than a data race
+	struct Slot
+	{
+		atomic<unsigned int> sequence;
+		atomic<int> digits;
+		atomic<long long> bid;
+		atomic<long long> ask;
+		atomic<long long> high;
+		atomic<long long> low;
+		// Nanoseconds since 1970
+		atomic<long long> sending_time;
+		atomic<long long> receive_time;
+	};
+
+	bool hasSlot(int id) const { return id >= 0 && (size_t)id < slot_count; }
+	// Slots are CACHE_LINE apart from a CACHE_LINE aligned start
+	Slot& slot(int id) const { return *reinterpret_cast<Slot*>(slots + id * CACHE_LINE); }
+
+	size_t slot_count;
+	char* memory;
+	char* slots;
+};
+
+#endif // QUOTECACHE_H
@@ -0,0 +1,146 @@
+#include "raw_message.h"
+
+const size_t RawMessage::npos;
+
+RawMessage::RawMessage(const string& wire, bool lazy)
+	: buffer(wire), parsed(0), checksum(-1)
+{
+	index(lazy);
+}
+
+void RawMessage::assign(string& wire, bool lazy)
+{
+	buffer.swap(wire);
+	wire.clear();
+	index(lazy);
+}
+
+void RawMessage::assign(const char* wire, size_t size, bool lazy)
+{
+	buffer.assign(wire, size);
+	index(lazy);
+}
+
+StringRef RawMessage::getFieldRef(int tag) const
+{
+	size_t position = find(tag);
+	if(position == npos)
+		throw FieldNotFound(tag);
+	return valueAt(position);
+}
+
+bool RawMessage::getFieldIfSet(int tag, StringRef& value) const
+{
+	size_t position = find(tag);
+	if(position == npos)
+		return false;
+	value = valueAt(position);
+	return true;
+}
+
+size_t RawMessage::find(int tag, size_t from) const
+{
+	for(size_t i = from; i < fields.size(); i++){
+		if(fields[i].tag == tag)
+			return i;
+	}
+	// Not in the indexed part; keep indexing only until the tag turns up
+	while(indexNext()){
+		if(fields.back().tag == tag && fields.size() - 1 >= from)
+			return fields.size() - 1;
+	}
+	return npos;
+}
+
+void RawMessage::index(bool lazy)
+{
+	fields.clear();
+	parsed = 0;
+	checksum = -1;
+	if(!lazy){
+		// One pass over the whole buffer, checksum included
+		if(!FixTokenizer::tokenize(buffer.data(), buffer.size(), fields, checksum))
+			throw InvalidMessage(buffer);
+		parsed = buffer.size();
+		return;
+	}
+	// Stop after the first field that is not part of the standard header
+	while(indexNext() && isHeaderField(fields.back().tag));
+}
+
+// Indexes one field. Length prefixed data fields (RawData and friends) are not
+// used by FXCM, so a SOH always ends a value
+bool RawMessage::indexNext() const
+{
+	const char* begin = buffer.data();
+	const char* end = begin + buffer.size();
+	const char* p = begin + parsed;
+	if(p >= end)
+		return false;
+
+	int tag = 0;
+	const char* tag_start = p;
+	while(p < end && *p >= '0' && *p <= '9')
+		tag = tag * 10 + (*p++ - '0');
+	if(p == end || *p != '=' || p == tag_start)
+		throw InvalidMessage(buffer);
+	const char* value = ++p;
+	p = (const char*)memchr(p, '\001', end - p);
+	if(p == NULL)
+		throw InvalidMessage(buffer);
+	FieldView field = { tag, (unsigned int)(value - begin), (unsigned int)(p - value) };
+	fields.push_back(field);
+	parsed = p + 1 - begin;
+	return true;
+}
+
+int RawMessage::checkSum() const
+{
+	if(checksum < 0){
+		// Leave out a trailing 10=nnn<SOH>
+		size_t length = buffer.size();
+		if(length >= 7 && buffer.compare(length - 7, 3, "10=") == 0)
+			length -= 7;
+		checksum = (int)(FixTokenizer::byteSum(buffer.data(), length) % 256);
+	}
+	return checksum;
+}
+
+bool RawMessage::isHeaderField(int tag)
+{
+	switch(tag){
+	case FIELD::BeginString:
+	case FIELD::BodyLength:
+	case FIELD::MsgType:
+	case FIELD::SenderCompID:
+	case FIELD::TargetCompID:
+	case FIELD::OnBehalfOfCompID:
+	case FIELD::DeliverToCompID:
+	case FIELD::SecureDataLen:
+	case FIELD::SecureData:
+	case FIELD::MsgSeqNum:
+	case FIELD::SenderSubID:
+	case FIELD::SenderLocationID:
+	case FIELD::TargetSubID:
+	case FIELD::TargetLocationID:
+	case FIELD::OnBehalfOfSubID:
+	case FIELD::OnBehalfOfLocationID:
+	case FIELD::DeliverToSubID:
+	case FIELD::DeliverToLocationID:
+	case FIELD::PossDupFlag:
+	case FIELD::PossResend:
+	case FIELD::SendingTime:
+	case FIELD::OrigSendingTime:
+	case FIELD::XmlDataLen:
+	case FIELD::XmlData:
+	case FIELD::MessageEncoding:
+	case FIELD::LastMsgSeqNumProcessed:
+	case FIELD::NoHops:
+	case FIELD::HopCompID:
+	case FIELD::HopSendingTime:
+	case FIELD::HopRefID:
+		return true;
+	default:
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef RAWMESSAGE_H
+#define RAWMESSAGE_H
+
+#include <string>
+#include "quickfix\Exceptions.h"
+#include "quickfix\FieldNumbers.h"
+#include "fix_tokenizer.h"
+#include "string_ref.h"
+
+using namespace std;
+using namespace FIX;
+
+// A FIX message kept in its wire form. The message owns one immutable copy of the
+// raw bytes and every field is a (tag, offset, length) entry pointing into it, so
+// parsing a message allocates nothing per field. A std::string for a value is only
+// built when getField is called; getFieldRef returns a view instead.
+//
+// Fields are stored in wire order, so repeating groups are read positionally: find
+// the count tag, then walk the entries that follow it (see find and valueAt).
+//
+// In lazy mode only the standard header is indexed up front (like
+// Message::setStringHeader); body fields are indexed as far as the first lookup
+// that needs them, so a handler that reads three fields of a snapshot does not
+// pay for the rest. Malformed body bytes are then reported by the lookup that
+// reaches them rather than by the constructor.
+class RawMessage
+{
+public:
+	typedef FixTokenizer::Token FieldView;
+	typedef FixTokenizer::Tokens Fields;
+	typedef Fields::const_iterator iterator;
+
+	RawMessage() : parsed(0), checksum(-1) {}
+	// Copies the wire bytes once and indexes them. Throws InvalidMessage if the
+	// bytes are not a sequence of tag=value<SOH> fields
+	explicit RawMessage(const string& wire, bool lazy = false);
+
+	// Takes the wire bytes out of wire (which is left empty) instead of copying them
+	void assign(string& wire, bool lazy = false);
+	// Copies the wire bytes into the buffer this message already has, so a message
+	// reused for a stream of them stops allocating once it has held the largest
+	void assign(const char* wire, size_t size, bool lazy = false);
+
+	bool isSetField(int tag) const { return find(tag) != npos; }
+	// Get a view of the value. Throws FieldNotFound if the field is not set
+	StringRef getFieldRef(int tag) const;
+	bool getFieldIfSet(int tag, StringRef& value) const;
+	// Get a copy of the value. Throws FieldNotFound if the field is not set
+	string getField(int tag) const { return getFieldRef(tag).str(); }
+
+	// Position of the first field with this tag at or after from, npos if none
+	size_t find(int tag, size_t from = 0) const;
+	// Number of fields; indexes the whole message if it is lazy
+	size_t fieldCount() const { indexAll(); return fields.size(); }
+	// Entry at a position returned by find. On a lazy message the reference is only
+	// valid until the next lookup
+	const FieldView& fieldAt(size_t position) const { return fields[position]; }
+	StringRef valueAt(size_t position) const
+	{ return StringRef(buffer.data() + fields[position].offset, fields[position].length); }
+
+	iterator begin() const { indexAll(); return fields.begin(); }
+	iterator end() const { indexAll(); return fields.end(); }
+
+	// The raw message exactly as it was received
+	const string& toString() const { return buffer; }
+	// Byte sum modulo 256 of everything before the CheckSum field, to compare with
+	// CheckSum(10). Comes for free from an eager parse; a lazy message computes it
+	// on the first call
+	int checkSum() const;
+
+	static bool isHeaderField(int tag);
+
+	static const size_t npos = (size_t)-1;
+
+private:
+	void index(bool lazy);
+	// Indexes the next field of the buffer, false once everything is indexed
+	bool indexNext() const;
+	void indexAll() const { while(indexNext()); }
+
+	string buffer;
+	// Index and parse position grow on lookup, which is logically const
+	mutable Fields fields;
+	mutable size_t parsed;
+	mutable int checksum;
+};
+
+#endif // RAWMESSAGE_H
\ No newline at end of file
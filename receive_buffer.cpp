@@ -0,0 +1,89 @@
+#include "receive_buffer.h"
+#include <cstring>
+#include "fix_tokenizer.h"
+
+namespace
+{
+const char SOH = '\001';
+const char BEGIN_STRING[] = "8=FIX";
+const size_t BEGIN_STRING_LENGTH = sizeof(BEGIN_STRING) - 1;
+// BeginString and BodyLength take far less; more bytes without a BodyLength are garbage
+const size_t MAX_HEADER = 64;
+
+// A framed message has to end with the CheckSum field, 10=nnn<SOH>
+bool endsWithCheckSum(const char* message, size_t length)
+{
+	return length >= 8 && message[length - 8] == SOH && message[length - 7] == '1'
+		&& message[length - 6] == '0' && message[length - 5] == '=' && message[length - 1] == SOH;
+}
+}
+
+ReceiveBuffer::ReceiveBuffer(size_t capacity)
+	: storage(capacity < (size_t)MIN_FREE ? (size_t)MIN_FREE : capacity)
+	, begin(0)
+	, end(0)
+{
+}
+
+char* ReceiveBuffer::prepare(size_t& free)
+{
+	if(storage.size() - end < MIN_FREE){
+		if(begin > 0){
+			memmove(&storage[0], &storage[begin], end - begin);
+			end -= begin;
+			begin = 0;
+		}
+		// next drops anything claiming to be longer than MAX_MESSAGE, so the buffer
+		// never has to hold more than one such message and a receive's worth after it
+		if(storage.size() - end < MIN_FREE && storage.size() < (size_t)MAX_MESSAGE + MIN_FREE){
+			size_t capacity = storage.size() * 2;
+			storage.resize(capacity < (size_t)MAX_MESSAGE + MIN_FREE ? capacity : (size_t)MAX_MESSAGE + MIN_FREE);
+		}
+	}
+	free = storage.size() - end;
+	return &storage[end];
+}
+
+void ReceiveBuffer::commit(size_t size)
+{
+	end += size;
+}
+
+bool ReceiveBuffer::next(const char*& message, size_t& length)
+{
+	while(begin < end){
+		const char* data = &storage[begin];
+		size_t available = end - begin;
+		size_t claimed;
+		// A BodyLength too large is dropped as soon as it is read, rather than
+		// waiting for a message that would never fit
+		if(!FixTokenizer::messageLength(data, available, length, claimed)
+			|| claimed > MAX_MESSAGE || (claimed == 0 && available > MAX_HEADER)
+			|| (length > 0 && !endsWithCheckSum(data, length))){
+			skipGarbage();
+			continue;
+		}
+		if(length == 0)
+			return false;
+		message = data;
+		begin += length;
+		return true;
+	}
+	// Empty; start over at the front so the next receive never needs a move
+	begin = end = 0;
+	return false;
+}
+
+// Drops bytes up to the next 8=FIX that could begin a message
+void ReceiveBuffer::skipGarbage()
+{
+	const char* data = &storage[0];
+	size_t i = begin + 1;
+	for(; i < end; i++){
+		size_t compare = end - i < BEGIN_STRING_LENGTH ? end - i : BEGIN_STRING_LENGTH;
+		// A match cut short by the end of the data is kept for the next receive
+		if(memcmp(data + i, BEGIN_STRING, compare) == 0)
+			break;
+	}
+	begin = i;
+}
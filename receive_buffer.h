@@ -0,0 +1,46 @@
+#ifndef RECEIVEBUFFER_H
+#define RECEIVEBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Receive buffer of one connection. The socket is read straight into the free
+// space after the unread bytes, and complete messages are framed in place with
+// FixTokenizer::messageLength, so nothing is copied before the session gets the
+// message and nothing is erased from the front per message. Unread bytes are
+// moved to the front only when the free space runs low, and the buffer doubles
+// when a single message does not fit, up to MAX_MESSAGE plus MIN_FREE.
+class ReceiveBuffer
+{
+public:
+	enum { INITIAL_CAPACITY = 64 * 1024, MIN_FREE = 4096 };
+	// Anything claiming to be longer is treated as garbage
+	enum { MAX_MESSAGE = 16 * 1024 * 1024 };
+
+	explicit ReceiveBuffer(size_t capacity = INITIAL_CAPACITY);
+
+	// Where to receive into and how much room there is; at least MIN_FREE bytes.
+	// Invalidates messages returned by next
+	char* prepare(size_t& free);
+	// Marks size bytes written at the prepared position as received
+	void commit(size_t size);
+
+	// The next complete message, valid until the following prepare. Bytes that do
+	// not start a message are skipped up to the next 8=FIX. Returns false
+	// once only a partial message is left
+	bool next(const char*& message, size_t& length);
+
+	size_t size() const { return end - begin; }
+	size_t capacity() const { return storage.size(); }
+
+private:
+	void skipGarbage();
+
+	vector<char> storage;
+	size_t begin;
+	size_t end;
+};
+
+#endif // RECEIVEBUFFER_H
@@ -0,0 +1,122 @@
+#include "risk_gate.h"
+
+namespace
+{
+// The stricter of two limits where 0 means none
+inline double tighter(double a, double b)
+{
+	if(a <= 0)
+		return b;
+	if(b <= 0)
+		return a;
+	return a < b ? a : b;
+}
+}
+
+RiskGate::RiskGate()
+	: kill_switch(false)
+	, rate(0)
+	, burst(0)
+	, tokens(0)
+{
+	defaults.max_order_qty = 0;
+	defaults.max_position = 0;
+}
+
+void RiskGate::setDefaultLimits(const RiskLimits& limits)
+{
+	Locker locker(mutex);
+	defaults = limits;
+	for(size_t i = 0; i < instruments.size(); i++)
+		combine(instruments[i]);
+}
+
+void RiskGate::setInstrumentLimits(int instrument_id, double min_qty, double max_qty, const RiskLimits& limits)
+{
+	Locker locker(mutex);
+	if(instrument_id >= (int)instruments.size())
+		instruments.resize(instrument_id + 1, InstrumentLimits());
+	InstrumentLimits& instrument = instruments[instrument_id];
+	instrument.known = true;
+	instrument.min_qty = min_qty;
+	instrument.max_qty = max_qty;
+	instrument.own = limits;
+	combine(instrument);
+}
+
+void RiskGate::setAccountLimits(const string& account, const RiskLimits& limits)
+{
+	Locker locker(mutex);
+	accounts.insert(account, limits);
+}
+
+void RiskGate::setRateLimit(double orders_per_second, double burst)
+{
+	Locker locker(mutex);
+	rate = orders_per_second;
+	this->burst = burst > 1 ? burst : 1;
+	tokens = this->burst;
+	last_refill = chrono::steady_clock::now();
+}
+
+RiskGate::Result RiskGate::check(const string& account, int instrument_id, double quantity, double exposure,
+	chrono::steady_clock::time_point now)
+{
+	if(kill_switch.load(memory_order_relaxed))
+		return KILL_SWITCH;
+
+	Locker locker(mutex);
+	if(instrument_id < 0 || instrument_id >= (int)instruments.size() || !instruments[instrument_id].known)
+		return UNKNOWN_INSTRUMENT;
+	const InstrumentLimits& instrument = instruments[instrument_id];
+	if(quantity < instrument.min_qty)
+		return BELOW_MIN_QTY;
+	if(instrument.max_qty > 0 && quantity > instrument.max_qty)
+		return ABOVE_MAX_QTY;
+
+	double max_order_qty = instrument.max_order_qty;
+	double max_position = instrument.max_position;
+	if(!accounts.empty()){
+		const RiskLimits* account_limits = accounts.find(account);
+		if(account_limits){
+			max_order_qty = tighter(max_order_qty, account_limits->max_order_qty);
+			max_position = tighter(max_position, account_limits->max_position);
+		}
+	}
+	if(max_order_qty > 0 && quantity > max_order_qty)
+		return ABOVE_ORDER_LIMIT;
+	if(max_position > 0 && exposure + quantity > max_position)
+		return ABOVE_POSITION_LIMIT;
+
+	if(rate > 0){
+		tokens += chrono::duration<double>(now - last_refill).count() * rate;
+		if(tokens > burst)
+			tokens = burst;
+		last_refill = now;
+		if(tokens < 1)
+			return RATE_LIMITED;
+		tokens -= 1;
+	}
+	return ACCEPTED;
+}
+
+const char* RiskGate::describe(Result result)
+{
+	switch(result){
+	case ACCEPTED: return "Accepted";
+	case KILL_SWITCH: return "Kill switch is on";
+	case UNKNOWN_INSTRUMENT: return "Instrument not in the SecurityList";
+	case BELOW_MIN_QTY: return "Quantity below the instrument minimum";
+	case ABOVE_MAX_QTY: return "Quantity above the instrument maximum";
+	case ABOVE_ORDER_LIMIT: return "Quantity above the order size limit";
+	case ABOVE_POSITION_LIMIT: return "Position limit would be exceeded";
+	case RATE_LIMITED: return "Order rate limit reached";
+	}
+	return "Unknown";
+}
+
+void RiskGate::combine(InstrumentLimits& limits) const
+{
+	limits.max_order_qty = tighter(limits.own.max_order_qty, defaults.max_order_qty);
+	limits.max_position = tighter(limits.own.max_position, defaults.max_position);
+}
@@ -0,0 +1,108 @@
+#ifndef RISKGATE_H
+#define RISKGATE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "quickfix\Mutex.h"
+#include "open_hash_map.h"
+
+using namespace std;
+using namespace FIX;
+
+const char RISK_MAX_ORDER_QTY[] = "RiskMaxOrderQty";
+const char RISK_MAX_POSITION[] = "RiskMaxPosition";
+const char RISK_MAX_ORDERS_PER_SECOND[] = "RiskMaxOrdersPerSecond";
+const char RISK_KILL_SWITCH[] = "RiskKillSwitch";
+
+// Limits on one order and on the exposure it would leave; 0 means no limit
+struct RiskLimits
+{
+	double max_order_qty;
+	double max_position;
+};
+
+// Pre-trade checks for outgoing orders, in this order: the kill switch, that the
+// instrument is known, FXCM's minimum and maximum quantity for the instrument
+// (9095/9094 of the SecurityList), the order size and exposure limits of the
+// instrument and of the account, and a token bucket on the order rate.
+//
+// The limits of each instrument are combined with the defaults when they are
+// set, into one record indexed by instrument ID, and per account overrides are
+// found through an OpenHashMap, so a check is a fixed handful of comparisons
+// whatever the number of instruments and accounts. bench/risk_gate_bench.cpp
+// times it.
+//
+// Exposure is supplied by the caller: what the account already holds or has
+// working in the instrument. The order is refused if exposure plus its quantity
+// is over the position limit.
+class RiskGate
+{
+public:
+	enum Result
+	{
+		ACCEPTED,
+		KILL_SWITCH,
+		UNKNOWN_INSTRUMENT,
+		BELOW_MIN_QTY,
+		ABOVE_MAX_QTY,
+		ABOVE_ORDER_LIMIT,
+		ABOVE_POSITION_LIMIT,
+		RATE_LIMITED
+	};
+
+	RiskGate();
+
+	void setDefaultLimits(const RiskLimits& limits);
+	// FXCM quantity bounds (0 if not given) and our own limits for an instrument;
+	// the stricter of these and the defaults applies
+	void setInstrumentLimits(int instrument_id, double min_qty, double max_qty, const RiskLimits& limits);
+	// Further limits for one account, on top of those of the instrument
+	void setAccountLimits(const string& account, const RiskLimits& limits);
+	// At most orders_per_second on average and burst at once; 0 turns it off
+	void setRateLimit(double orders_per_second, double burst);
+
+	// Refuses every order while on; safe from any thread
+	void setKillSwitch(bool on) { kill_switch.store(on, memory_order_relaxed); }
+	bool isKillSwitchOn() const { return kill_switch.load(memory_order_relaxed); }
+
+	// Checks an order of quantity in an instrument (-1 if unknown) for an account.
+	// An accepted order uses up a token of the rate limit
+	Result check(const string& account, int instrument_id, double quantity, double exposure,
+		chrono::steady_clock::time_point now);
+	Result check(const string& account, int instrument_id, double quantity, double exposure)
+	{ return check(account, instrument_id, quantity, exposure, chrono::steady_clock::now()); }
+
+	static const char* describe(Result result);
+
+private:
+	RiskGate(const RiskGate&);
+	RiskGate& operator=(const RiskGate&);
+
+	// Limits of an instrument as set, and combined with the defaults
+	struct InstrumentLimits
+	{
+		bool known;
+		double min_qty;
+		double max_qty;
+		RiskLimits own;
+		double max_order_qty;
+		double max_position;
+	};
+
+	void combine(InstrumentLimits& limits) const;
+
+	Mutex mutex;
+	atomic<bool> kill_switch;
+	RiskLimits defaults;
+	vector<InstrumentLimits> instruments;
+	OpenHashMap<RiskLimits> accounts;
+
+	double rate;
+	double burst;
+	double tokens;
+	chrono::steady_clock::time_point last_refill;
+};
+
+#endif // RISKGATE_H
@@ -0,0 +1,110 @@
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// A vector which keeps its first N elements inside the object itself and only
+// touches the heap once it grows past that. Used for FixTokenizer::Tokens, the
+// tag/offset table of a message, whose typical size is known up front, so that
+// the common case does not allocate at all.
+template <typename T, size_t N>
+class SmallVector
+{
+public:
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	SmallVector() : data(inline_data()), count(0), capacity(N) {}
+
+	SmallVector(const SmallVector& copy) : data(inline_data()), count(0), capacity(N)
+	{
+		reserve(copy.count);
+		for(size_t i = 0; i < copy.count; i++)
+			new (data + i) T(copy.data[i]);
+		count = copy.count;
+	}
+
+	SmallVector& operator=(const SmallVector& rhs)
+	{
+		if(this == &rhs)
+			return *this;
+		clear();
+		reserve(rhs.count);
+		for(size_t i = 0; i < rhs.count; i++)
+			new (data + i) T(rhs.data[i]);
+		count = rhs.count;
+		return *this;
+	}
+
+	~SmallVector()
+	{
+		clear();
+		if(data != inline_data())
+			::operator delete(data);
+	}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	T& operator[](size_t i) { return data[i]; }
+	const T& operator[](size_t i) const { return data[i]; }
+	T& back() { return data[count - 1]; }
+	const T& back() const { return data[count - 1]; }
+
+	iterator begin() { return data; }
+	iterator end() { return data + count; }
+	const_iterator begin() const { return data; }
+	const_iterator end() const { return data + count; }
+
+	// Destroys all elements but keeps the storage, so a container that is
+	// reused for the next message does not give back a grown buffer
+	void clear()
+	{
+		for(size_t i = 0; i < count; i++)
+			data[i].~T();
+		count = 0;
+	}
+
+	void reserve(size_t wanted)
+	{
+		if(wanted <= capacity)
+			return;
+		size_t grown = capacity * 2;
+		if(grown < wanted)
+			grown = wanted;
+		T* moved = static_cast<T*>(::operator new(grown * sizeof(T)));
+		for(size_t i = 0; i < count; i++){
+			new (moved + i) T(std::move(data[i]));
+			data[i].~T();
+		}
+		if(data != inline_data())
+			::operator delete(data);
+		data = moved;
+		capacity = grown;
+	}
+
+	void push_back(const T& value)
+	{
+		if(count == capacity){
+			// value may live inside our own storage
+			T temp(value);
+			reserve(count + 1);
+			new (data + count) T(std::move(temp));
+		}else{
+			new (data + count) T(value);
+		}
+		count++;
+	}
+
+private:
+	T* inline_data() { return reinterpret_cast<T*>(storage); }
+
+	alignas(T) unsigned char storage[N * sizeof(T)];
+	T* data;
+	size_t count;
+	size_t capacity;
+};
+
+#endif // SMALLVECTOR_H
\ No newline at end of file
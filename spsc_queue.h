@@ -0,0 +1,89 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Elements live in a ring of preallocated slots that are written and read
+// in place, so a slot holding a string keeps its capacity from one lap to the
+// next and a steady stream allocates nothing. The two indices sit on separate
+// cache lines, and each side keeps a cached copy of the other's index so that it
+// only touches the shared line when the ring looks full or empty.
+template<typename T>
+class SpscQueue
+{
+public:
+	// capacity is rounded up to a power of two
+	explicit SpscQueue(size_t capacity)
+		: head(0), cached_tail(0), tail(0), cached_head(0)
+	{
+		size_t size = 2;
+		while(size < capacity)
+			size *= 2;
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	// Producer: the slot to fill, or NULL if the queue is full. The element is not
+	// visible to the consumer until commitPush
+	T* beginPush()
+	{
+		size_t position = tail.load(memory_order_relaxed);
+		if(position - cached_head > mask){
+			cached_head = head.load(memory_order_acquire);
+			if(position - cached_head > mask)
+				return NULL;
+		}
+		return &slots[position & mask];
+	}
+	void commitPush()
+	{
+		tail.store(tail.load(memory_order_relaxed) + 1, memory_order_release);
+	}
+
+	// Consumer: the oldest element, or NULL if the queue is empty. The slot stays
+	// valid until pop
+	T* front()
+	{
+		size_t position = head.load(memory_order_relaxed);
+		if(position == cached_tail){
+			cached_tail = tail.load(memory_order_acquire);
+			if(position == cached_tail)
+				return NULL;
+		}
+		return &slots[position & mask];
+	}
+	void pop()
+	{
+		head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+	}
+
+	size_t capacity() const { return slots.size(); }
+	// Approximate when called while the other side is running
+	size_t size() const { return tail.load(memory_order_acquire) - head.load(memory_order_acquire); }
+
+private:
+	SpscQueue(const SpscQueue&);
+	SpscQueue& operator=(const SpscQueue&);
+
+	enum { CACHE_LINE = 64 };
+
+	vector<T> slots;
+	size_t mask;
+	// Padding rather than alignas, which heap allocations before C++17 ignore
+	char padding_before[CACHE_LINE];
+	// Consumer side
+	atomic<size_t> head;
+	size_t cached_tail;
+	char padding_between[CACHE_LINE];
+	// Producer side
+	atomic<size_t> tail;
+	size_t cached_head;
+	char padding_after[CACHE_LINE];
+};
+
+#endif // SPSCQUEUE_H
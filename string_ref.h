@@ -0,0 +1,30 @@
+#ifndef STRINGREF_H
+#define STRINGREF_H
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Reference to a run of characters owned by someone else; the toolset we build
+// with has no std::string_view
+struct StringRef
+{
+	const char* data;
+	size_t length;
+
+	StringRef() : data(NULL), length(0) {}
+	StringRef(const char* data, size_t length) : data(data), length(length) {}
+
+	string str() const { return string(data, length); }
+	bool empty() const { return length == 0; }
+
+	bool operator==(const char* rhs) const
+	{ return strlen(rhs) == length && memcmp(data, rhs, length) == 0; }
+	bool operator!=(const char* rhs) const
+	{ return !(*this == rhs); }
+	bool operator==(const StringRef& rhs) const
+	{ return rhs.length == length && memcmp(data, rhs.data, length) == 0; }
+};
+
+#endif // STRINGREF_H
\ No newline at end of file
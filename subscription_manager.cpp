@@ -0,0 +1,240 @@
+#include "subscription_manager.h"
+#include <algorithm>
+#include "fast_convertors.h"
+
+SubscriptionManager::SubscriptionManager(OutboundThrottle& throttle, size_t batch_size)
+	: throttle(throttle)
+	, batch_size(batch_size > 0 ? batch_size : (size_t)DEFAULT_BATCH_SIZE)
+	, request_counter(0)
+	, logged_on(false)
+{
+	// The constant part: full book depth of Bid, Offer, High and Low
+	FIX44::MarketDataRequest& message = request.message();
+	message.setField(MarketDepth(0));
+	FIX44::MarketDataRequest::NoMDEntryTypes entry_types;
+	entry_types.setField(MDEntryType(MDEntryType_BID));
+	message.addGroup(entry_types);
+	entry_types.setField(MDEntryType(MDEntryType_OFFER));
+	message.addGroup(entry_types);
+	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_HIGH_PRICE));
+	message.addGroup(entry_types);
+	entry_types.setField(MDEntryType(MDEntryType_TRADING_SESSION_LOW_PRICE));
+	message.addGroup(entry_types);
+}
+
+int SubscriptionManager::subscribe(const vector<string>& symbols, const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	vector<string> added;
+	for(size_t i = 0; i < symbols.size(); i++){
+		if(symbol_requests.find(symbols[i]) != symbol_requests.end())
+			continue;
+		// Claimed now so that a symbol listed twice is only added once
+		symbol_requests[symbols[i]] = "";
+		rejected.erase(symbols[i]);
+		added.push_back(symbols[i]);
+	}
+	// Otherwise onLogon sends them
+	if(!logged_on)
+		return 0;
+	return addBatches(added, session_ID);
+}
+
+int SubscriptionManager::unsubscribe(const vector<string>& symbols, const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	// The batches the symbols belong to, and their symbols that stay subscribed
+	map<string, vector<string> > affected;
+	for(size_t i = 0; i < symbols.size(); i++){
+		SymbolRequests::iterator request = symbol_requests.find(symbols[i]);
+		if(request == symbol_requests.end())
+			continue;
+		if(!request->second.empty() && affected.find(request->second) == affected.end())
+			affected[request->second] = batches[request->second];
+		symbol_requests.erase(request);
+	}
+
+	int sent = 0;
+	vector<string> remaining;
+	for(map<string, vector<string> >::iterator i = affected.begin(); i != affected.end(); ++i){
+		send(i->first, i->second, false, session_ID);
+		sent++;
+		for(size_t j = 0; j < i->second.size(); j++){
+			if(symbol_requests.find(i->second[j]) != symbol_requests.end())
+				remaining.push_back(i->second[j]);
+		}
+		eraseBatch(i->first);
+	}
+	return sent + addBatches(remaining, session_ID);
+}
+
+int SubscriptionManager::unsubscribeAll(const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	int sent = 0;
+	for(Batches::iterator i = batches.begin(); i != batches.end(); ++i){
+		send(i->first, i->second, false, session_ID);
+		sent++;
+	}
+	batches.clear();
+	split_depths.clear();
+	symbol_requests.clear();
+	return sent;
+}
+
+int SubscriptionManager::onLogon(const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	logged_on = true;
+	batches.clear();
+	split_depths.clear();
+	vector<string> symbols;
+	symbols.reserve(symbol_requests.size());
+	for(SymbolRequests::const_iterator i = symbol_requests.begin(); i != symbol_requests.end(); ++i)
+		symbols.push_back(i->first);
+	return addBatches(symbols, session_ID);
+}
+
+void SubscriptionManager::onLogout()
+{
+	Locker locker(mutex);
+	logged_on = false;
+	batches.clear();
+	split_depths.clear();
+	for(SymbolRequests::iterator i = symbol_requests.begin(); i != symbol_requests.end(); ++i)
+		i->second.clear();
+}
+
+vector<string> SubscriptionManager::onReject(const string& request_ID, const string& symbol, char reason,
+	const SessionID& session_ID)
+{
+	Locker locker(mutex);
+	vector<string> found;
+	Batches::iterator batch = batches.find(request_ID);
+	// A batch cancelled or replaced since
+	if(batch == batches.end())
+		return found;
+
+	vector<string>& symbols = batch->second;
+	SplitDepths::const_iterator split = split_depths.find(request_ID);
+	int depth = split == split_depths.end() ? 0 : split->second;
+	if(!symbol.empty()){
+		vector<string>::iterator i = std::find(symbols.begin(), symbols.end(), symbol);
+		if(i == symbols.end())
+			return found;
+		symbols.erase(i);
+		found.push_back(symbol);
+	}else if(symbols.size() > 1 && reason == MDReqRejReason_UNKNOWN_SYMBOL && depth < MAX_SPLIT_DEPTH){
+		vector<string> first(symbols.begin(), symbols.begin() + symbols.size() / 2);
+		vector<string> second(symbols.begin() + symbols.size() / 2, symbols.end());
+		eraseBatch(request_ID);
+		addBatches(first, session_ID, depth + 1);
+		addBatches(second, session_ID, depth + 1);
+		return found;
+	}else{
+		found.swap(symbols);
+	}
+
+	if(symbols.empty())
+		eraseBatch(request_ID);
+	for(size_t i = 0; i < found.size(); i++){
+		symbol_requests.erase(found[i]);
+		rejected.insert(found[i]);
+	}
+	return found;
+}
+
+bool SubscriptionManager::isSubscribed(const string& symbol) const
+{
+	Locker locker(mutex);
+	return symbol_requests.find(symbol) != symbol_requests.end();
+}
+
+bool SubscriptionManager::isRejected(const string& symbol) const
+{
+	Locker locker(mutex);
+	return rejected.find(symbol) != rejected.end();
+}
+
+string SubscriptionManager::getRequestID(const string& symbol) const
+{
+	Locker locker(mutex);
+	SymbolRequests::const_iterator i = symbol_requests.find(symbol);
+	return i == symbol_requests.end() ? string() : i->second;
+}
+
+vector<string> SubscriptionManager::getSymbols() const
+{
+	Locker locker(mutex);
+	vector<string> symbols;
+	symbols.reserve(symbol_requests.size());
+	for(SymbolRequests::const_iterator i = symbol_requests.begin(); i != symbol_requests.end(); ++i)
+		symbols.push_back(i->first);
+	return symbols;
+}
+
+size_t SubscriptionManager::getBatchCount() const
+{
+	Locker locker(mutex);
+	return batches.size();
+}
+
+int SubscriptionManager::addBatches(const vector<string>& symbols, const SessionID& session_ID, int depth)
+{
+	int sent = 0;
+	for(size_t first = 0; first < symbols.size(); first += batch_size){
+		size_t last = first + batch_size < symbols.size() ? first + batch_size : symbols.size();
+		string request_ID = nextRequestID();
+		vector<string>& batch = batches[request_ID];
+		batch.assign(symbols.begin() + first, symbols.begin() + last);
+		for(size_t i = 0; i < batch.size(); i++)
+			symbol_requests[batch[i]] = request_ID;
+		if(depth > 0)
+			split_depths[request_ID] = depth;
+		send(request_ID, batch, true, session_ID);
+		sent++;
+	}
+	return sent;
+}
+
+void SubscriptionManager::eraseBatch(const string& request_ID)
+{
+	batches.erase(request_ID);
+	split_depths.erase(request_ID);
+}
+
+// The same request subscribes (SubscriptionRequestType 1) and, with the MDReqID
+// of the subscription, cancels (2) it. Only the MDReqID, the request type and the
+// symbols change between requests
+void SubscriptionManager::send(const string& request_ID, const vector<string>& symbols, bool subscribe,
+	const SessionID& session_ID)
+{
+	FIX44::MarketDataRequest& message = request.message();
+	request.set(MDReqID(request_ID));
+	request.set(SubscriptionRequestType(subscribe
+		? SubscriptionRequestType_SNAPSHOT_PLUS_UPDATES
+		: SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST));
+
+	size_t held = message.groupCount(FIELD::NoRelatedSym);
+	while(held > symbols.size())
+		message.FieldMap::removeGroup((int)held--, FIELD::NoRelatedSym);
+	for(size_t i = 0; i < held; i++)
+		request.group((int)i + 1, FIELD::NoRelatedSym).setField(Symbol(symbols[i]));
+	if(held < symbols.size()){
+		FIX44::MarketDataRequest::NoRelatedSym symbols_group;
+		for(size_t i = held; i < symbols.size(); i++){
+			symbols_group.setField(Symbol(symbols[i]));
+			message.addGroup(symbols_group);
+		}
+	}
+	request.set(NoRelatedSym((int)symbols.size()));
+
+	request.send(throttle, session_ID);
+}
+
+string SubscriptionManager::nextRequestID()
+{
+	char buffer[FastIntConvertor::MAX_CHARS];
+	char* end = FastIntConvertor::toChars(buffer, buffer + sizeof(buffer), (int)++request_counter);
+	return "MD_" + string(buffer, end);
+}
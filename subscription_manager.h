@@ -0,0 +1,112 @@
+#ifndef SUBSCRIPTIONMANAGER_H
+#define SUBSCRIPTIONMANAGER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "quickfix\Mutex.h"
+#include "quickfix\SessionID.h"
+#include "quickfix\fix44\MarketDataRequest.h"
+#include "message_template.h"
+#include "outbound_throttle.h"
+
+using namespace std;
+using namespace FIX;
+
+const char MARKET_DATA_BATCH_SIZE[] = "MarketDataBatchSize";
+
+// The market data subscriptions of an MD session, made in batches: one
+// MarketDataRequest carries up to batch_size symbols in its NoRelatedSym group,
+// so subscribing to the whole SecurityList takes a handful of messages instead
+// of one per symbol. Each batch is known by its MDReqID, and unsubscribing sends
+// the same MDReqID back with SubscriptionRequestType 2, as FXCM requires.
+//
+// A subscription can only be cancelled as a whole, so removing some symbols of
+// a batch cancels the batch and subscribes the rest of it again as a new one.
+//
+// The manager remembers which symbols are wanted, not just what was sent. FXCM
+// forgets all subscriptions when the session drops, so onLogout discards the
+// batches and onLogon subscribes to everything wanted again in one burst of
+// batches. Symbols subscribed to while the session is down wait for that.
+//
+// A MarketDataRequestReject naming a Symbol rejects that symbol alone. One that
+// does not rejects the whole batch. If its MDReqRejReason is UNKNOWN_SYMBOL the
+// batch is split in two and both halves sent again, so a bad symbol among a
+// hundred is found with a few more requests, and a batch of one is the bad
+// symbol itself. A batch is split at most MAX_SPLIT_DEPTH times over; past that,
+// or for any other reason, its symbols are all rejected, since sending them
+// again would only be rejected again. Rejected symbols are dropped until they
+// are subscribed to again. Requests go out through an OutboundThrottle. Safe to
+// use from several threads.
+//
+// All requests are filled into one MessageTemplate, whose MarketDepth and four
+// MDEntryType groups are set once. A request overwrites the Symbol of the
+// NoRelatedSym groups already there, and adds or removes only as many groups as
+// its batch differs in size from the previous one.
+class SubscriptionManager
+{
+public:
+	enum { DEFAULT_BATCH_SIZE = 100 };
+	// Enough to narrow a batch of 128 down to single symbols
+	enum { MAX_SPLIT_DEPTH = 7 };
+
+	explicit SubscriptionManager(OutboundThrottle& throttle, size_t batch_size = DEFAULT_BATCH_SIZE);
+
+	// Subscribes to the symbols that are not subscribed yet. Returns the number of
+	// MarketDataRequests sent
+	int subscribe(const vector<string>& symbols, const SessionID& session_ID);
+	// Unsubscribes from those of symbols that are subscribed
+	int unsubscribe(const vector<string>& symbols, const SessionID& session_ID);
+	int unsubscribeAll(const SessionID& session_ID);
+
+	// Called on logon and logout of the MD session. Returns the number of
+	// MarketDataRequests sent
+	int onLogon(const SessionID& session_ID);
+	void onLogout();
+	// Handles a MarketDataRequestReject; symbol is its Symbol or empty, and reason
+	// its MDReqRejReason or 0. Returns the symbols found to be rejected
+	vector<string> onReject(const string& request_ID, const string& symbol, char reason,
+		const SessionID& session_ID);
+
+	// True for a wanted symbol, whether or not its request has been sent
+	bool isSubscribed(const string& symbol) const;
+	bool isRejected(const string& symbol) const;
+	// MDReqID of the batch holding symbol; empty if it is not subscribed or
+	// waiting for logon
+	string getRequestID(const string& symbol) const;
+	vector<string> getSymbols() const;
+	size_t getBatchCount() const;
+
+private:
+	typedef map<string, vector<string> > Batches;
+	typedef map<string, string> SymbolRequests;
+	typedef map<string, int> SplitDepths;
+	typedef set<string> Symbols;
+
+	// Sends new batches for symbols, none of which may be subscribed; depth is how
+	// many times they have been split out of a rejected batch
+	int addBatches(const vector<string>& symbols, const SessionID& session_ID, int depth = 0);
+	void eraseBatch(const string& request_ID);
+	// Sends the MarketDataRequest of a batch, subscribing or cancelling it
+	void send(const string& request_ID, const vector<string>& symbols, bool subscribe,
+		const SessionID& session_ID);
+	string nextRequestID();
+
+	mutable Mutex mutex;
+	OutboundThrottle& throttle;
+	size_t batch_size;
+	unsigned int request_counter;
+	// MDReqID to the symbols of its batch
+	Batches batches;
+	// MDReqID to its split depth, for batches split out of a rejected one
+	SplitDepths split_depths;
+	// Each wanted symbol to the MDReqID of its batch, empty while logged out
+	SymbolRequests symbol_requests;
+	Symbols rejected;
+	bool logged_on;
+	// Used under mutex only
+	MessageTemplate<FIX44::MarketDataRequest> request;
+};
+
+#endif // SUBSCRIPTIONMANAGER_H
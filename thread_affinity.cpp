@@ -0,0 +1,47 @@
+#include "thread_affinity.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool pinCurrentThread(int cpu)
+{
+#ifdef _WIN32
+	if(cpu < 0 || cpu >= (int)(sizeof(DWORD_PTR) * 8))
+		return false;
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+	if(cpu < 0 || cpu >= CPU_SETSIZE)
+		return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+void nameCurrentThread(const string& name)
+{
+#ifdef _WIN32
+	// SetThreadDescription is looked up at run time so older systems still start
+	typedef HRESULT (WINAPI *SetThreadDescriptionProc)(HANDLE, PCWSTR);
+	SetThreadDescriptionProc set_description = (SetThreadDescriptionProc)GetProcAddress(
+		GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+	if(set_description){
+		wstring wide(name.begin(), name.end());
+		set_description(GetCurrentThread(), wide.c_str());
+	}
+#elif defined(__linux__)
+	pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
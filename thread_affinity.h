@@ -0,0 +1,17 @@
+#ifndef THREADAFFINITY_H
+#define THREADAFFINITY_H
+
+#include <string>
+
+using namespace std;
+
+// Restricts the calling thread to one CPU, so that a spinning network thread
+// keeps its core and its cache. Returns false if the CPU does not exist or the
+// system refused
+bool pinCurrentThread(int cpu);
+
+// Names the calling thread for debuggers and profilers; Linux keeps the first
+// 15 characters, Windows needs Windows 10 1607 or later
+void nameCurrentThread(const string& name);
+
+#endif // THREADAFFINITY_H
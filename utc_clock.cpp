@@ -0,0 +1,182 @@
+#include "utc_clock.h"
+#include "quickfix\Exceptions.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+// FILETIME counts 100 ns intervals since 1601-01-01
+WallTime fromFileTime(const FILETIME& file_time)
+{
+	const unsigned long long EPOCH_DIFFERENCE = 116444736000000000ULL;
+	unsigned long long ticks = ((unsigned long long)file_time.dwHighDateTime << 32) | file_time.dwLowDateTime;
+	ticks -= EPOCH_DIFFERENCE;
+	WallTime time = { (long long)(ticks / 10000000ULL), (int)(ticks % 10000000ULL) * 100 };
+	return time;
+}
+#else
+WallTime readClock(clockid_t id)
+{
+	timespec spec;
+	clock_gettime(id, &spec);
+	WallTime time = { (long long)spec.tv_sec, (int)spec.tv_nsec };
+	return time;
+}
+#endif
+
+const int NANOS_DIVISOR[] = { 1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+
+inline bool readDigits(const char* p, int count, int& value)
+{
+	value = 0;
+	for(int i = 0; i < count; i++){
+		if(p[i] < '0' || p[i] > '9')
+			return false;
+		value = value * 10 + (p[i] - '0');
+	}
+	return true;
+}
+
+inline void writeDigits(char* p, unsigned int value, int count)
+{
+	for(int i = count - 1; i >= 0; i--){
+		p[i] = (char)('0' + value % 10);
+		value /= 10;
+	}
+}
+}
+
+WallTime PreciseClock::now() const
+{
+#ifdef _WIN32
+	FILETIME file_time;
+	GetSystemTimePreciseAsFileTime(&file_time);
+	return fromFileTime(file_time);
+#else
+	return readClock(CLOCK_REALTIME);
+#endif
+}
+
+WallTime CoarseClock::now() const
+{
+#ifdef _WIN32
+	FILETIME file_time;
+	GetSystemTimeAsFileTime(&file_time);
+	return fromFileTime(file_time);
+#elif defined(CLOCK_REALTIME_COARSE)
+	return readClock(CLOCK_REALTIME_COARSE);
+#else
+	return readClock(CLOCK_REALTIME);
+#endif
+}
+
+const Clock& Clock::named(const string& name)
+{
+	static PreciseClock precise;
+	static CoarseClock coarse;
+	if(name == "Precise")
+		return precise;
+	if(name == "Coarse")
+		return coarse;
+	throw FIX::ConfigError("ClockSource must be Precise or Coarse, not " + name);
+}
+
+TimestampFormatter::TimestampFormatter(int fraction_digits)
+	: fraction_digits(fraction_digits >= 9 ? 9 : fraction_digits >= 6 ? 6 : fraction_digits >= 3 ? 3 : 0)
+	, cached_second(-1)
+	, prefix_length(17)
+{
+	buffer[0] = '\0';
+}
+
+int TimestampFormatter::precision(int setting)
+{
+	if(setting != 0 && setting != 3 && setting != 6 && setting != 9)
+		throw FIX::ConfigError("TimestampPrecision must be 0, 3, 6 or 9");
+	return setting;
+}
+
+const char* TimestampFormatter::format(const WallTime& time)
+{
+	if(time.seconds != cached_second)
+		buildPrefix(time.seconds);
+	char* p = buffer + prefix_length;
+	if(fraction_digits > 0){
+		*p++ = '.';
+		writeDigits(p, (unsigned int)(time.nanos / NANOS_DIVISOR[fraction_digits]), fraction_digits);
+		p += fraction_digits;
+	}
+	*p = '\0';
+	return buffer;
+}
+
+// Writes YYYYMMDD-HH:MM:SS for a second since the epoch, using the days-to-civil
+// conversion from http://howardhinnant.github.io/date_algorithms.html
+void TimestampFormatter::buildPrefix(long long seconds)
+{
+	long long days = seconds / 86400;
+	int second_of_day = (int)(seconds % 86400);
+	if(second_of_day < 0){
+		second_of_day += 86400;
+		days--;
+	}
+
+	long long z = days + 719468;
+	long long era = (z >= 0 ? z : z - 146096) / 146097;
+	unsigned int day_of_era = (unsigned int)(z - era * 146097);
+	unsigned int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+	unsigned int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	unsigned int month_part = (5 * day_of_year + 2) / 153;
+	unsigned int day = day_of_year - (153 * month_part + 2) / 5 + 1;
+	unsigned int month = month_part < 10 ? month_part + 3 : month_part - 9;
+	unsigned int year = (unsigned int)(year_of_era + era * 400) + (month <= 2 ? 1 : 0);
+
+	writeDigits(buffer, year, 4);
+	writeDigits(buffer + 4, month, 2);
+	writeDigits(buffer + 6, day, 2);
+	buffer[8] = '-';
+	writeDigits(buffer + 9, second_of_day / 3600, 2);
+	buffer[11] = ':';
+	writeDigits(buffer + 12, second_of_day / 60 % 60, 2);
+	buffer[14] = ':';
+	writeDigits(buffer + 15, second_of_day % 60, 2);
+	cached_second = seconds;
+}
+// The inverse of buildPrefix: civil-to-days from the same page
+bool parseTimestamp(const string& text, WallTime& time)
+{
+	const char* p = text.c_str();
+	int year, month, day, hour, minute, second;
+	if(text.size() < 17 || p[8] != '-' || p[11] != ':' || p[14] != ':'
+		|| !readDigits(p, 4, year) || !readDigits(p + 4, 2, month) || !readDigits(p + 6, 2, day)
+		|| !readDigits(p + 9, 2, hour) || !readDigits(p + 12, 2, minute) || !readDigits(p + 15, 2, second))
+		return false;
+	if(month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+		return false;
+
+	int nanos = 0;
+	if(text.size() > 17){
+		int digits = (int)text.size() - 18;
+		if(p[17] != '.' || digits < 1 || digits > 9 || !readDigits(p + 18, digits, nanos))
+			return false;
+		nanos *= NANOS_DIVISOR[digits];
+	}
+
+	long long y = month <= 2 ? year - 1 : year;
+	long long era = (y >= 0 ? y : y - 399) / 400;
+	unsigned int year_of_era = (unsigned int)(y - era * 400);
+	unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	unsigned int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	long long days = era * 146097 + (long long)day_of_era - 719468;
+
+	time.seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+	time.nanos = nanos;
+	return true;
+}
@@ -0,0 +1,77 @@
+#ifndef UTCCLOCK_H
+#define UTCCLOCK_H
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// A UTC time as seconds since 1970-01-01 and the nanoseconds within that second
+struct WallTime
+{
+	long long seconds;
+	int nanos;
+};
+
+// Where the current time comes from. The session code and the logs share one
+// clock, chosen with the ClockSource setting:
+//   Precise - the exact system time on every call
+//   Coarse  - the time as of the last system tick (1-16 ms old on Windows, a few ms
+//             on Linux), which is considerably cheaper to read
+class Clock
+{
+public:
+	virtual ~Clock() {}
+	virtual WallTime now() const = 0;
+
+	// The clock for a ClockSource value; throws ConfigError if the name is unknown
+	static const Clock& named(const string& name);
+};
+
+class PreciseClock : public Clock
+{
+public:
+	WallTime now() const;
+};
+
+class CoarseClock : public Clock
+{
+public:
+	WallTime now() const;
+};
+
+// Formats UTC timestamps as YYYYMMDD-HH:MM:SS[.fff]. The text up to the seconds is
+// kept from the previous call and only rebuilt when the second changes; within a
+// second only the fractional digits are written. One formatter per thread.
+class TimestampFormatter
+{
+public:
+	// fraction_digits: 0 for whole seconds, 3 for milliseconds, 6 for microseconds
+	// or 9 for nanoseconds. Other values are rounded down to one of those
+	explicit TimestampFormatter(int fraction_digits = 3);
+
+	// Fraction digits for a TimestampPrecision setting value; throws ConfigError
+	// unless it is 0, 3, 6 or 9
+	static int precision(int setting);
+
+	// Formats time into an internal buffer and returns it, null terminated. The
+	// text stays valid until the next call
+	const char* format(const WallTime& time);
+	size_t length() const { return prefix_length + (fraction_digits > 0 ? fraction_digits + 1 : 0); }
+
+	int getFractionDigits() const { return fraction_digits; }
+
+private:
+	void buildPrefix(long long seconds);
+
+	int fraction_digits;
+	long long cached_second;
+	size_t prefix_length;
+	char buffer[32];
+};
+
+// Reads a YYYYMMDD-HH:MM:SS[.f...] timestamp such as SendingTime, with up to nine
+// fractional digits. Returns false if text is not one
+bool parseTimestamp(const string& text, WallTime& time);
+
+#endif // UTCCLOCK_H
\ No newline at end of file